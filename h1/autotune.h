@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runtime choice of how many threads each phase of a generation gets
+// - whether a parallel loop pays off depends on the phase size, the genome length and the core count,
+// - so it is measured instead of guessed: during the first generations every phase is timed with
+// - 1, 2, 4, ... threads (kSamples runs each, the fastest run counts) and the fastest width wins
+// - the 1-thread runs come first and give the per-item cost - a phase whose whole serial run is
+// - below kMinParallelWork stays serial without trying any other width
+// - a width only wins over a narrower one if it is at least kMinGain faster (threads aren't free)
+// - the decision is for the mean genome length it was measured at - when that drifts by more than
+// - kRetuneDrift (genomes grow or shrink towards the target length) the phase is tuned again
+
+enum class Phase { Evaluate, CrossOver, Mutate };
+
+inline const char *PhaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Evaluate: return "evaluate";
+        case Phase::CrossOver: return "crossover";
+        case Phase::Mutate: return "mutate";
+    }
+    return "?";
+}
+
+struct Autotuner {
+    static constexpr int kSamples = 3;
+    static constexpr double kMinParallelWork = 50'000;  // ns
+    static constexpr double kMinGain = 1.1;
+    static constexpr double kRetuneDrift = 0.5;
+
+    struct PhaseTuning {
+        // The widths still to try, then the chosen one (threads != 0)
+        std::vector<int> widths;
+        std::vector<double> best;
+        int sample = 0;
+        int threads = 0;
+        double length = 0;
+        double itemNs = 0;
+    };
+
+    int workers;
+    // Print every decision as it is made - they are kept in decisions either way
+    bool verbose;
+    PhaseTuning phases[3];
+    std::vector<std::string> decisions;
+
+    Autotuner(int workers, bool verbose) : workers(workers), verbose(verbose) {
+        for (PhaseTuning &tuning : phases) Reset(tuning, 0);
+    }
+
+    void Reset(PhaseTuning &tuning, double length) {
+        tuning = PhaseTuning();
+        for (int width = 1; width < workers; width *= 2) tuning.widths.push_back(width);
+        tuning.widths.push_back(workers);
+        tuning.best.assign(tuning.widths.size(), std::numeric_limits<double>::max());
+        tuning.length = length;
+    }
+
+    bool Tuned(Phase phase) const { return phases[int(phase)].threads != 0; }
+
+    // Width of the next run of the phase over genomes of this mean length
+    int Threads(Phase phase, double meanLength) {
+        PhaseTuning &tuning = phases[int(phase)];
+        if (tuning.threads != 0 && std::abs(meanLength - tuning.length) > kRetuneDrift * tuning.length) {
+            std::ostringstream line;
+            line << "autotune " << PhaseName(phase) << ": mean genome length " << tuning.length << " -> " << meanLength << ", retuning";
+            Log(line.str());
+            Reset(tuning, meanLength);
+        }
+        if (tuning.threads != 0) return tuning.threads;
+        if (tuning.sample == 0 && tuning.length == 0) tuning.length = meanLength;
+        return tuning.widths[tuning.sample / kSamples];
+    }
+
+    // Reports the run Threads() asked for - count items took `elapsed`
+    void Record(Phase phase, int count, std::chrono::nanoseconds elapsed) {
+        PhaseTuning &tuning = phases[int(phase)];
+        if (tuning.threads != 0 || count == 0) return;
+        const int trial = tuning.sample / kSamples;
+        tuning.best[trial] = std::min(tuning.best[trial], double(elapsed.count()));
+        tuning.sample++;
+        if (tuning.sample % kSamples != 0) return;
+
+        if (trial == 0) {
+            tuning.itemNs = tuning.best[0] / count;
+            if (tuning.best[0] < kMinParallelWork || tuning.widths.size() == 1) {
+                Decide(phase, tuning, 0, count);
+                return;
+            }
+        }
+        if (trial + 1 < int(tuning.widths.size())) return;
+        int chosen = 0;
+        for (int c = 1; c < int(tuning.widths.size()); c++) {
+            if (tuning.best[chosen] > kMinGain * tuning.best[c]) chosen = c;
+        }
+        Decide(phase, tuning, chosen, count);
+    }
+
+    void Decide(Phase phase, PhaseTuning &tuning, int chosen, int count) {
+        tuning.threads = tuning.widths[chosen];
+        std::ostringstream line;
+        line << "autotune " << PhaseName(phase) << ": " << tuning.itemNs << " ns/item x " << count << " items at mean length "
+             << tuning.length << " ->";
+        if (chosen == 0 && tuning.best[0] < kMinParallelWork) line << " too small,";
+        line << " " << tuning.threads << " thread(s), chunks of " << (count + tuning.threads - 1) / tuning.threads << " (";
+        for (int c = 0; c < int(tuning.widths.size()); c++) {
+            if (tuning.best[c] == std::numeric_limits<double>::max()) continue;
+            line << (c ? " " : "") << tuning.widths[c] << ":" << tuning.best[c] / 1000 << "us";
+        }
+        line << ")";
+        Log(line.str());
+    }
+
+    void Log(const std::string &line) {
+        if (verbose) std::cout << line << std::endl;
+        decisions.push_back(line);
+    }
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <execution>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "thread_pool.h"
+
+// Execution backends - the one way GA runs a parallel loop
+// - ParallelFor(count, body) calls body(worker, first, last) on disjoint ranges that cover [0, count)
+// - worker is in 0..Workers()-1 and no two calls that run at the same time get the same one,
+// - so it can index per-worker state (GA::workers) without locking
+// - a backend may call body several times for one worker (TBB splits ranges as it likes)
+// - width limits the loop to that many workers (chunks of count / width items), 1 runs it inline on the caller
+// - the engines that need a team of threads meeting at barriers (RunCellular(), RunPipelined(),
+// - RunSteadyState()) can't run on every backend and keep using the WorkerPool directly
+
+enum class Backend { Serial, StdExecution, ThreadPool, Tbb, OpenMP };
+
+inline const char *BackendName(Backend backend) {
+    switch (backend) {
+        case Backend::Serial: return "serial";
+        case Backend::StdExecution: return "std";
+        case Backend::ThreadPool: return "pool";
+        case Backend::Tbb: return "tbb";
+        case Backend::OpenMP: return "openmp";
+    }
+    return "?";
+}
+
+// Returns false for an unknown name
+inline bool ParseBackend(const std::string &name, Backend &backend) {
+    for (Backend b : { Backend::Serial, Backend::StdExecution, Backend::ThreadPool, Backend::Tbb, Backend::OpenMP }) {
+        if (name == BackendName(b)) {
+            backend = b;
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef _OPENMP
+constexpr bool kHaveOpenMP = true;
+#else
+constexpr bool kHaveOpenMP = false;
+#endif
+
+// Only OpenMP depends on how the program was compiled (-fopenmp)
+inline bool BackendSupported(Backend backend) { return backend != Backend::OpenMP || kHaveOpenMP; }
+
+// What ParallelFor() runs - body(worker, first, last)
+using LoopBody = FunctionRef<void(int, int, int)>;
+
+struct Executor {
+    const Backend backend;
+    // What the executor was made for - Workers() can be less (the serial one always has 1)
+    const int threads;
+    const bool pinned;
+
+    Executor(Backend backend, int threads, bool pinned) : backend(backend), threads(threads), pinned(pinned) {}
+    virtual ~Executor() = default;
+
+    virtual int Workers() const = 0;
+    virtual void ParallelFor(int count, int width, LoopBody body) = 0;
+
+    void ParallelFor(int count, LoopBody body) { ParallelFor(count, Workers(), body); }
+
+    // How many chunks a loop of `width` workers is cut into - 1 means run it inline
+    int Chunks(int count, int width) const { return std::max(1, std::min({ width, Workers(), count })); }
+};
+
+struct SerialExecutor : Executor {
+    SerialExecutor(int threads) : Executor(Backend::Serial, threads, false) {}
+
+    int Workers() const override { return 1; }
+
+    void ParallelFor(int count, int, LoopBody body) override {
+        if (count > 0) body(0, 0, count);
+    }
+};
+
+// One static chunk per worker, run by std::for_each(std::execution::par) - the library decides the threads
+// - every chunk index is handed out exactly once, so it can be the worker index
+struct StdExecutor : Executor {
+    std::vector<int> chunks;
+
+    StdExecutor(int threads) : Executor(Backend::StdExecution, threads, false), chunks(threads) {
+        std::iota(chunks.begin(), chunks.end(), 0);
+    }
+
+    int Workers() const override { return threads; }
+
+    void ParallelFor(int count, int width, LoopBody body) override {
+        const int used = Chunks(count, width);
+        if (used == 1) {
+            if (count > 0) body(0, 0, count);
+            return;
+        }
+        std::for_each(std::execution::par, chunks.begin(), chunks.begin() + used, [&](int chunk) {
+            const auto [first, last] = ChunkOf(count, chunk, used);
+            if (first < last) body(chunk, first, last);
+        });
+    }
+};
+
+// The spin-then-park WorkerPool - worker w gets the static chunk w
+struct PoolExecutor : Executor {
+    WorkerPool pool;
+
+    PoolExecutor(int threads, bool pin) : Executor(Backend::ThreadPool, threads, pin), pool(threads, pin) {}
+
+    int Workers() const override { return pool.Size(); }
+
+    void ParallelFor(int count, int width, LoopBody body) override {
+        const int used = Chunks(count, width);
+        if (used == 1) {
+            if (count > 0) body(0, 0, count);
+            return;
+        }
+        // Workers past `used` get an empty chunk and go straight back to sleep
+        pool.Run([&](int w) {
+            if (w >= used) return;
+            const auto [first, last] = ChunkOf(count, w, used);
+            if (first < last) body(w, first, last);
+        });
+    }
+};
+
+// tbb::parallel_for in an arena of `threads` threads - the worker is the arena's thread index
+// - the range is split by TBB, but never finer than count / (4 * threads) items
+// - a narrower loop gets chunks of count / width items, so at most width threads get one
+struct TbbExecutor : Executor {
+    tbb::global_control control;
+    tbb::task_arena arena;
+
+    TbbExecutor(int threads)
+        : Executor(Backend::Tbb, threads, false), control(tbb::global_control::max_allowed_parallelism, threads), arena(threads) {}
+
+    int Workers() const override { return threads; }
+
+    void ParallelFor(int count, int width, LoopBody body) override {
+        const int used = Chunks(count, width);
+        if (used == 1) {
+            if (count > 0) body(0, 0, count);
+            return;
+        }
+        const int grain = used < threads ? (count + used - 1) / used : std::max(1, count / (4 * threads));
+        arena.execute([&] {
+            tbb::parallel_for(tbb::blocked_range<int>(0, count, grain), [&](const tbb::blocked_range<int> &range) {
+                body(tbb::this_task_arena::current_thread_index(), range.begin(), range.end());
+            });
+        });
+    }
+};
+
+#ifdef _OPENMP
+// A static OpenMP loop over one chunk per thread - the worker is omp_get_thread_num()
+struct OpenMPExecutor : Executor {
+    OpenMPExecutor(int threads) : Executor(Backend::OpenMP, threads, false) {}
+
+    int Workers() const override { return threads; }
+
+    void ParallelFor(int count, int width, LoopBody body) override {
+        const int chunks = Chunks(count, width);
+        if (chunks == 1) {
+            if (count > 0) body(0, 0, count);
+            return;
+        }
+#pragma omp parallel for schedule(static, 1) num_threads(chunks)
+        for (int chunk = 0; chunk < chunks; chunk++) {
+            const auto [first, last] = ChunkOf(count, chunk, chunks);
+            if (first < last) body(omp_get_thread_num(), first, last);
+        }
+    }
+};
+#endif
+
+// nullptr when the backend wasn't compiled in (OpenMP without -fopenmp)
+inline std::unique_ptr<Executor> MakeExecutor(Backend backend, int threads, bool pin) {
+    switch (backend) {
+        case Backend::Serial: return std::make_unique<SerialExecutor>(threads);
+        case Backend::StdExecution: return std::make_unique<StdExecutor>(threads);
+        case Backend::ThreadPool: return std::make_unique<PoolExecutor>(threads, pin);
+        case Backend::Tbb: return std::make_unique<TbbExecutor>(threads);
+        case Backend::OpenMP:
+#ifdef _OPENMP
+            return std::make_unique<OpenMPExecutor>(threads);
+#else
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
@@ -1,29 +1,77 @@
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <random>
 #include <thread>
+#include <atomic>
 #include <mutex>
 #include <execution>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
+
+#include "rng.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "wire.h"
+#include "numa_shm.h"
+#include "net.h"
+#include "executor.h"
+#include "autotune.h"
+
+#ifdef __linux__
+#include <signal.h>
+#include <poll.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#endif
+
 std::mutex mtx;
 
 // Change the value of numOfThreads to change the number of threads to be used
 // Leave numOfThreads to -1 if you want the system to figure it out
 
-// I have parallelized the Run() method so that the generations are split into chunks
-// - and each chunk is then ranked, crossed-over and mutated
-// - and then merged to the shared vector<Individual> generation
+// Run() splits every single generation over a persistent pool of numOfThreads workers
+// - each worker breeds a fixed range of child slots with its own random stream
+// - and the workers only meet at barriers (see the comment above Run())
+// - pass --threads=N to override numOfThreads from the command line
+// - with --deterministic every child slot gets its own seeded stream instead
+// - so the run is reproducible for any numOfThreads (./h1.out --check determinism verifies it)
 // Also the std::sort() is now implemented to run in paralled
 // - by adding std::execution::par_unseq as the first argument and including <execution>
 
+// IslandModel is the other way to use many threads - one whole GA per thread
+// - the islands never wait for each other and only swap their best over lock-free rings
+// - ./h1.out --bench islands compares its time to fitness 0 with Run()
+// RunSteadyState() drops generations altogether - workers replace single slots under sequence locks
+// - ./h1.out --bench steady compares its evaluations per second with Run()
+// RunCellular() keeps the generations but mates only grid neighbours (./h1.out --bench cellular)
+// RunPipelined() scores children on other threads while the next batch is bred (./h1.out --bench pipeline)
+// RunTbb() is the same generation on TBB algorithms (./h1.out --bench tbb)
+// Run(), RunWithP() and RankIndividuals() run their loops on a pluggable backend (executor.h)
+// - ./h1.out --backend=serial|std|pool|tbb|openmp, ./h1.out --bench backends compares them
+// - and by default ./h1.out measures how many threads each of those loops is worth (autotune.h, --no-autotune)
+// Children that can't become elites are only scored until that is certain (GAParams::cull, --no-cull)
+// Mutations go where the parent is wrong (MutationMode::Guided, --mutation=uniform for the old operator)
+// On NUMA machines ./h1.out --numa [--islands=N] runs one island process per node instead (NumaIslands)
+// Across machines: ./h1.out --coordinator [--host=A] [--port=P] [--nodes=N] and ./h1.out --node [--host=A] [--port=P]
+
 // I have also parallelized the RankIndividuals() function so it is divided in chunks
-// - each chunk is then given to an individual thread
-// - this is just an idea - the uncommented version isn't parallelized
-// - look over the commented RankIndividuals() if you want
-// - it isn't used as of right now because on my machine it is slower
+// - each chunk is then evaluated by one worker of the same pool Run() uses
+// - the first version created new threads on every call, which is why it was slower
 
 // In addition I think it is possible to parallelize the Run() method in another way
 // - so that the for() loop for CrossOver() is done in chunks
@@ -34,23 +82,161 @@ std::mutex mtx;
 // ^^^~~~> if you want you can try it and tell me if it is correct or not - thanks!
 
 int numOfThreads = -1;
+// Pin worker w of the pool to CPU w (--pin on the command line)
+bool pinThreads = false;
+
+// Fitness is an exact integer - lower is better, 0 means the guess equals the target
+// - every char of distance costs 256 and every char of length difference costs 256 * 256
+using Fitness = uint64_t;
+constexpr Fitness kUnknownFitness = std::numeric_limits<Fitness>::max();
+// An exact fitness is a multiple of 256 - this bit marks a culled one, whose scan was cut short
+// - set by the bounded evaluations for genomes that certainly lost (see GuessEvaluator::EvaluateBounded())
+// - a culled value is the partial sum (* 256, plus the length penalty) with this bit set - not the true fitness
+// - without the bit it is <= the true fitness, and it is > the bound it lost to
+// - so it still orders after everything it lost to and can be ranked, weighted and compared as usual
+constexpr Fitness kBoundedFitness = 1;
+
+// kUnknownFitness counts as inexact too
+inline bool ExactFitness(Fitness fitness) { return (fitness & kBoundedFitness) == 0; }
 
 struct GuessEvaluator {
     std::string target;
 
-    float Evaluate(const std::string &guess) const {
-        float sum = 0;
-        for (int c = 0; c < std::min(target.size(), guess.size()); c++) {
-            const float diff = std::fabs(target[c] - guess[c]);
-            sum += diff * 256;
+    // The per-char distance is summed as an exact integer by the SIMD kernels in simd.h
+    Fitness Evaluate(std::string_view guess) const {
+        const size_t common = std::min(target.size(), guess.size());
+        const Fitness sum = ActiveKernels().sumAbsDiff(target.data(), guess.data(), common) * 256;
+        return sum + LengthPenalty(guess.size());
+    }
+
+    // Like Evaluate(), but stops scanning as soon as the fitness is certainly above bound
+    // - the length difference is known before the scan, so a genome can lose without being read at all
+    // - the result is exact when it is <= bound, otherwise culled: > bound with kBoundedFitness set (see FromSum())
+    // - kUnknownFitness as bound is a plain Evaluate()
+    Fitness EvaluateBounded(std::string_view guess, Fitness bound) const {
+        if (bound == kUnknownFitness) return Evaluate(guess);
+        const Fitness penalty = LengthPenalty(guess.size());
+        const uint64_t limit = SumLimit(penalty, bound);
+        const size_t common = std::min(target.size(), guess.size());
+        const uint64_t sum = SumAbsDiffUntil(ActiveKernels().sumAbsDiff, target.data(), guess.data(), common, limit);
+        return FromSum(sum, limit, penalty);
+    }
+
+    // Fitness of a batch of genomes in an arena - genome i is at arena + slots[i] * stride, lengths[slots[i]] chars
+    // - writes count values to out and returns it
+    // - the batch goes through one kernel call (SumAbsDiffBatch() in simd.h), not one dispatch per genome
+    // - with a bound every value is as EvaluateBounded() would return it
+    const Fitness *EvaluateBatch(const char *arena, size_t stride, const int *lengths, const int *slots, size_t count,
+                                 Fitness *out, Fitness bound = kUnknownFitness) const {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = bound == kUnknownFitness ? kNoLimit : SumLimit(LengthPenalty(size_t(lengths[slots[i]])), bound);
+        }
+        ActiveKernels().sumAbsDiffBatch(target.data(), target.size(), arena, stride, lengths, slots, count, out);
+        for (size_t i = 0; i < count; i++) {
+            const Fitness penalty = LengthPenalty(size_t(lengths[slots[i]]));
+            out[i] = bound == kUnknownFitness ? out[i] * 256 + penalty : FromSum(out[i], SumLimit(penalty, bound), penalty);
+        }
+        return out;
+    }
+
+    // The smallest distance sum that makes a genome with this length penalty lose to bound
+    static uint64_t SumLimit(Fitness penalty, Fitness bound) { return penalty > bound ? 0 : (bound - penalty) / 256 + 1; }
+
+    // A sum that reached limit may be partial - its fitness is flagged, it is > bound but maybe < the true fitness
+    static Fitness FromSum(uint64_t sum, uint64_t limit, Fitness penalty) {
+        return (sum * 256 + penalty) | (sum >= limit ? kBoundedFitness : 0);
+    }
+
+    // Evaluate() that also writes where guess differs from the target (SumAbsDiffMask*() in simd.h)
+    // - bit c of mask is set when guess[c] != target[c], for c below the common length
+    // - mask needs (common length + 63) / 64 words
+    Fitness EvaluateWithMask(std::string_view guess, uint64_t *mask) const {
+        const size_t common = std::min(target.size(), guess.size());
+        const Fitness sum = ActiveKernels().sumAbsDiffMask(target.data(), guess.data(), common, mask) * 256;
+        return sum + LengthPenalty(guess.size());
+    }
+
+    // Fitness of child computed from its parent's fitness instead of a full scan
+    // - child must equal parent everywhere except at the positions in changed
+    // - (sorted, unique, all below tailStart) and from tailStart to the end
+    // - costs O(changed + tail) instead of O(length)
+    Fitness EvaluateDelta(std::string_view parent, Fitness parentFitness, std::string_view child,
+                          const std::vector<int> &changed, size_t tailStart) const {
+        // Unsigned wrap-around is fine here - the final value is always a valid fitness
+        Fitness sum = parentFitness - LengthPenalty(parent.size());
+        for (int c : changed) {
+            if (c >= target.size()) break;
+            sum += Fitness(std::abs(int(target[c]) - int(child[c]))) * 256;
+            sum -= Fitness(std::abs(int(target[c]) - int(parent[c]))) * 256;
+        }
+        const size_t parentEnd = std::min(parent.size(), target.size());
+        if (tailStart < parentEnd) {
+            sum -= ActiveKernels().sumAbsDiff(target.data() + tailStart, parent.data() + tailStart, parentEnd - tailStart) * 256;
         }
-        const float diffInLen = std::abs(int(guess.size()) - int(target.size()));
-        const float totalDiff = sum + diffInLen * 256 * 256;
-        assert(totalDiff >= 0.f);
-        return totalDiff;
+        const size_t childEnd = std::min(child.size(), target.size());
+        if (tailStart < childEnd) {
+            sum += ActiveKernels().sumAbsDiff(target.data() + tailStart, child.data() + tailStart, childEnd - tailStart) * 256;
+        }
+        return sum + LengthPenalty(child.size());
+    }
+
+    Fitness LengthPenalty(size_t length) const {
+        const Fitness diffInLen = length > target.size() ? length - target.size() : target.size() - length;
+        return diffInLen * 256 * 256;
     }
 };
 
+// How RankIndividuals() orders the generation
+// - FullSort: the whole generation is sorted by fitness
+// - TopK: only the eliteCount best are moved to the front (in order), the rest stay unordered
+// - RadixSort: full order, sorting packed (fitness, index) keys and moving every individual once
+// - Run() only needs the elites in order - parents are picked uniformly at random
+enum class RankMode { FullSort, TopK, RadixSort };
+
+// Which positions Mutate() changes
+// - Uniform: every position with chance mutationRate
+// - Guided: only positions where the parent differs from the target (the evaluator's mismatch bitmap),
+// - each with chance mutationRate but at least one - a matching char can only get worse
+// - and a parent that already has the target's length passes it on
+enum class MutationMode { Uniform, Guided };
+
+// LSD radix sort of 64-bit keys, one byte per pass
+// - a single counting pass builds all 8 histograms
+// - bytes that are the same in every key are skipped (usually the high ones)
+void RadixSort(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch) {
+    size_t counts[8][256] = {};
+    for (uint64_t key : keys) {
+        for (int digit = 0; digit < 8; digit++) {
+            counts[digit][(key >> (digit * 8)) & 0xff]++;
+        }
+    }
+    scratch.resize(keys.size());
+    for (int digit = 0; digit < 8; digit++) {
+        size_t *count = counts[digit];
+        if (count[(keys[0] >> (digit * 8)) & 0xff] == keys.size()) continue;
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            const size_t n = count[bucket];
+            count[bucket] = offset;
+            offset += n;
+        }
+        for (uint64_t key : keys) {
+            scratch[count[(key >> (digit * 8)) & 0xff]++] = key;
+        }
+        keys.swap(scratch);
+    }
+}
+
+// The most square rows x cols grid with rows * cols == count (used for tori of islands and cells)
+std::pair<int, int> GridShape(int count) {
+    int rows = 1;
+    for (int r = 1; r * r <= count; r++) {
+        if (count % r == 0) rows = r;
+    }
+    return { rows, count / rows };
+}
+
 struct GAParams {
     int generationSize = 500;
     int eliteCount = 10;
@@ -58,24 +244,321 @@ struct GAParams {
     int mutatedCount = 200;
     float mutationRate = 0.05f;
     int individualSize = 300;
+    RankMode rankMode = RankMode::TopK;
+    MutationMode mutation = MutationMode::Uniform;
+    uint64_t seed = 42;
+    // Progress lines of Run() - the benchmarks turn them off
+    bool verbose = true;
+    // Every child slot draws from its own stream GARng::Stream(seed, StreamId(generation, slot))
+    // - so a seed gives the same population history for any numOfThreads (--deterministic)
+    bool deterministic = false;
+    // Size of this GA's own pool - 0 means numOfThreads (islands run one single-threaded GA each)
+    int threads = 0;
+    // Backend of this GA's parallel loops (--backend=<name>, see executor.h)
+    Backend backend = Backend::ThreadPool;
+    // Let an Autotuner pick the threads of every phase (autotune.h) instead of always using all of them
+    bool autotune = false;
+    // Run() and RunWithP() stop scoring a child once it can't be an elite any more (EvaluateBounded())
+    // - only mutants and random individuals are culled - the elites and crossovers (the mutants' parents) stay exact
+    bool cull = false;
+};
+
+// The engine behind all GA randomness - Philox4x32 (rng.h) can be dropped in instead
+using GARng = Xoshiro256pp;
+
+// All genomes of one generation in one contiguous byte arena (structure of arrays)
+// - slot c owns the `stride` bytes at offset c * stride, so offsets don't need their own array
+// - and a child can be written straight into its slot without touching any other
+// - lengths and fitness are kept in separate arrays next to the bytes
+// - and so is the mismatch bitmap of every slot that was scored with one (guided mutation)
+struct Population {
+    int stride = 0;
+    std::vector<char> bytes;
+    std::vector<int> lengths;
+    std::vector<Fitness> diffs;
+    // stride / 64 words per slot, bit c set where the genome differs from the target (EvaluateWithMask())
+    // - masked[slot] says the bitmap belongs to the genome in the slot - whoever rewrites a genome clears it
+    std::vector<uint64_t> masks;
+    std::vector<uint8_t> masked;
+
+    // maxLength is rounded up to whole cache lines
+    void Resize(int count, int maxLength) {
+        stride = (maxLength + 63) / 64 * 64;
+        bytes.resize(size_t(count) * stride);
+        lengths.resize(count, 0);
+        diffs.resize(count, kUnknownFitness);
+        masks.resize(size_t(count) * (stride / 64));
+        masked.assign(count, 0);
+    }
+
+    int Size() const { return int(lengths.size()); }
+    char *Data(int slot) { return bytes.data() + size_t(slot) * stride; }
+    const char *Data(int slot) const { return bytes.data() + size_t(slot) * stride; }
+    std::string_view Genome(int slot) const { return { Data(slot), size_t(lengths[slot]) }; }
+    uint64_t *Mask(int slot) { return masks.data() + size_t(slot) * (stride / 64); }
+    const uint64_t *Mask(int slot) const { return masks.data() + size_t(slot) * (stride / 64); }
+
+    // diffs[slot] is valid until the genome changes - copies (e.g. the elites) keep it
+    bool Evaluated(int slot) const { return diffs[slot] != kUnknownFitness; }
+
+    // The bitmap goes along if there is one
+    void Copy(int slot, const Population &from, int fromSlot) {
+        std::memcpy(Data(slot), from.Data(fromSlot), from.lengths[fromSlot]);
+        lengths[slot] = from.lengths[fromSlot];
+        diffs[slot] = from.diffs[fromSlot];
+        masked[slot] = from.masked[fromSlot];
+        if (masked[slot]) std::memcpy(Mask(slot), from.Mask(fromSlot), (lengths[slot] + 63) / 64 * sizeof(uint64_t));
+    }
+
+    // A genome that comes from outside (another island, process or node)
+    void Assign(int slot, const char *data, int length, Fitness diff) {
+        std::memcpy(Data(slot), data, length);
+        lengths[slot] = length;
+        diffs[slot] = diff;
+        masked[slot] = 0;
+    }
 };
 
 struct GA {
-    struct Individual {
-        std::string data;
-        float diff = -1.f;
+    // RandomIndividual() makes genomes of 1 to kMaxRandomLength chars
+    static constexpr int kMaxRandomLength = 30;
+
+    struct RankKey {
+        Fitness diff;
+        int index;
+
+        bool operator<(const RankKey &other) const {
+            return diff < other.diff || (diff == other.diff && index < other.index);
+        }
+    };
+
+    // Counted per generation and printed next to the duration
+    struct GenerationStats {
+        int evaluated = 0;
+        int deltaEvaluated = 0;
+        int skipped = 0;
+        // Scored with a bound and found to be worse than it (a subset of evaluated)
+        int culled = 0;
     };
-    std::vector<Individual> generation;
-    std::mt19937 rng;
+
+    // Everything a thread needs to breed children on its own
+    // - workers[0] is also used by the serial code (RankIndividuals(), RunWithP(), the benchmarks)
+    struct Worker {
+        GARng rng;
+        std::vector<int> mutatedPositions;
+        std::vector<uint16_t> crossOverRandom;
+        // Mismatch bitmap of the parent of a guided Mutate()
+        std::vector<uint64_t> mismatchMask;
+        // (fitness, slot) of the children this worker made - Run() merges them into the ranking
+        std::vector<RankKey> candidates;
+        GenerationStats stats;
+        // Parents and child of RunSteadyState() - copied out of the shared generation
+        Population scratch;
+        // Slots and fitness of one EvaluateBatch() call of RankIndividuals()
+        std::vector<int> batchSlots;
+        std::vector<Fitness> batchFitness;
+    };
+
+    // generation and nextGeneration are swapped after every generation
+    // - both are allocated once, so a generation allocates nothing after warm-up
+    Population generation;
+    Population nextGeneration;
+    // Slots of generation ordered by fitness - at least the first eliteCount are valid
+    std::vector<int> ranking;
+    // Worker w draws from the stream GARng(params.seed) jumped ahead w times
+    std::vector<Worker> workers;
+    std::unique_ptr<WorkerPool> pool;
+    std::unique_ptr<Executor> executor;
+    // Made with the executor when params.autotune is set
+    std::unique_ptr<Autotuner> tuner;
     GuessEvaluator &eval;
     GAParams params;
     std::string allowedSymbols;
-    std::mutex mtx;
+    std::vector<RankKey> rankKeys;
+    std::vector<uint64_t> packedKeys;
+    std::vector<uint64_t> packedScratch;
+    // Wall time of every generation of the last Run() / RunWithP()
+    LatencyStats latency;
+    // Generations made so far by Run() / RunWithP()
+    long long generationIndex = 0;
+    // Bound for CrossOver() and the evaluations of Run() / RunWithP() - kUnknownFitness (no bound)
+    // - unless params.cull is set and a generation is being made, see CullBound()
+    Fitness cullBound = kUnknownFitness;
+    std::vector<Fitness> boundScratch;
+    // Sequence lock of every slot of generation for RunSteadyState() - odd while a writer owns the slot
+    // - bytes, lengths and diffs of a slot are read and written with relaxed atomics (RelaxedCopy() in thread_pool.h)
+    // - while it runs, as readers race with the writer by design
+    std::unique_ptr<std::atomic<uint32_t>[]> slotVersions;
+    int slotVersionCount = 0;
+    // Running minimum over everything RunSteadyState() wrote into generation
+    std::atomic<Fitness> bestFitness{ kUnknownFitness };
 
-    GA(GuessEvaluator &eval, GAParams params) : rng(42), eval(eval), params(params) {
+    GA(GuessEvaluator &eval, GAParams params) : eval(eval), params(params) {
         InitSymbols();
-        for (int c = 0; c < params.generationSize; c++) {
-            generation.push_back(RandomIndividual());
+        const int populationSize = std::max(params.generationSize, params.eliteCount + params.crossOverCount + params.mutatedCount);
+        const int maxLength = std::max(params.individualSize, kMaxRandomLength);
+        generation.Resize(populationSize, maxLength);
+        nextGeneration.Resize(populationSize, maxLength);
+        boundScratch.reserve(populationSize);
+        AddWorkers(1);
+        for (int c = 0; c < generation.Size(); c++) {
+            RandomIndividual(workers[0], generation, c);
+        }
+    }
+
+    void AddWorkers(int count) {
+        while (workers.size() < count) {
+            Worker worker = MakeWorker(GARng(params.seed));
+            for (int jump = 0; jump < workers.size(); jump++) {
+                worker.rng.Jump();
+            }
+            workers.push_back(std::move(worker));
+        }
+    }
+
+    Worker MakeWorker(GARng rng) const {
+        Worker worker{ rng };
+        worker.crossOverRandom.resize(generation.stride);
+        worker.mismatchMask.resize(generation.stride / 64 + 1);
+        // Sized for the worst case up front, so no generation allocates (--check allocations)
+        // - a mutant has at most stride positions, a worker gets at most every slot of a loop
+        worker.mutatedPositions.reserve(generation.stride);
+        worker.candidates.reserve(generation.Size());
+        worker.batchSlots.reserve(generation.Size());
+        worker.batchFitness.reserve(generation.Size());
+        return worker;
+    }
+
+    static int ThreadCount() {
+        if(numOfThreads == -1) {
+            numOfThreads = std::thread::hardware_concurrency();
+            if(numOfThreads == 0) {
+                numOfThreads = 1;
+            }
+        }
+        return numOfThreads;
+    }
+
+    // Threads of this GA - its own params.threads, else numOfThreads
+    int Threads() const { return params.threads > 0 ? params.threads : ThreadCount(); }
+
+    // The executor outlives a single Run() - it is only rebuilt when params.backend, the thread count or pinThreads change
+    // - Run(), RunWithP() and RankIndividuals() all dispatch onto it
+    // - a GA with its own params.threads leaves pinning to whoever owns its thread (IslandModel)
+    // - a backend that wasn't compiled in falls back to the thread pool (for this GA only)
+    Executor &Exec() {
+        const int threads = Threads();
+        const bool pin = pinThreads && params.threads == 0;
+        if (!BackendSupported(params.backend)) {
+            std::cerr << "backend " << BackendName(params.backend) << " is not compiled in, using " << BackendName(Backend::ThreadPool) << std::endl;
+            params.backend = Backend::ThreadPool;
+        }
+        const Backend wanted = params.backend;
+        if (!executor || executor->backend != wanted || executor->threads != threads || executor->pinned != (pin && wanted == Backend::ThreadPool)) {
+            executor.reset();
+            executor = MakeExecutor(wanted, threads, pin && wanted == Backend::ThreadPool);
+            tuner.reset();
+        }
+        if (params.autotune && !tuner) tuner = std::make_unique<Autotuner>(executor->Workers(), params.verbose);
+        AddWorkers(executor->Workers());
+        return *executor;
+    }
+
+    // One parallel loop of a generation - on all workers, or as many as the tuner picked for the phase
+    // - while the phase is being tuned the loop is timed for it
+    // - returns the width it ran at
+    int RunPhase(Phase phase, int count, LoopBody body) {
+        Executor &executor = Exec();
+        if (!tuner) {
+            executor.ParallelFor(count, body);
+            return executor.Workers();
+        }
+        const int width = tuner->Threads(phase, MeanLength());
+        if (tuner->Tuned(phase)) {
+            executor.ParallelFor(count, width, body);
+            return width;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        executor.ParallelFor(count, width, body);
+        tuner->Record(phase, count, std::chrono::high_resolution_clock::now() - start);
+        return width;
+    }
+
+    double MeanLength() const {
+        long long sum = 0;
+        for (int c = 0; c < generation.Size(); c++) sum += generation.lengths[c];
+        return double(sum) / generation.Size();
+    }
+
+    // The team engines (RunCellular(), RunSteadyState(), RunPipelined()) need a WorkerPool whatever the backend
+    // - the one of the thread pool executor is shared, so the default backend has only one set of threads
+    WorkerPool &Pool() {
+        const int threads = Threads();
+        const bool pin = pinThreads && params.threads == 0;
+        if (auto *shared = dynamic_cast<PoolExecutor *>(executor.get());
+            shared && shared->pool.Size() == threads && shared->pool.pinned == pin) {
+            pool.reset();
+            AddWorkers(threads);
+            return shared->pool;
+        }
+        if (!pool || pool->Size() != threads || pool->pinned != pin) {
+            pool.reset();
+            pool = std::make_unique<WorkerPool>(threads, pin);
+        }
+        AddWorkers(threads);
+        return *pool;
+    }
+
+    // Slot for the next migrant from another island, process or node, counting down from `slot`
+    // - start with generation.Size(): the last slots hold random individuals and are replaced first
+    // - an elite is never replaced, -1 means there is no slot left
+    // - the next Run() ranks the generation again, so a good migrant can become an elite right away
+    // - only ranking[0..eliteCount) are elites - with RankMode::FullSort / RadixSort the ranking covers every slot
+    int NextImmigrantSlot(int slot) const {
+        const auto elitesEnd = ranking.begin() + std::min<int>(params.eliteCount, ranking.size());
+        do {
+            slot--;
+        } while (slot >= 0 && std::find(ranking.begin(), elitesEnd, slot) != elitesEnd);
+        return slot;
+    }
+
+    // Fitness of the eliteCount-th best of the ranked generation - with params.cull every mutant or random child worse than it is culled
+    // - strictly worse: a child that ties could still take an elite place by its slot
+    Fitness CullBound() const {
+        if (!params.cull || params.eliteCount == 0 || int(ranking.size()) < params.eliteCount) return kUnknownFitness;
+        return generation.diffs[ranking[params.eliteCount - 1]];
+    }
+
+    // A full (bounded by cullBound) evaluation of a child
+    Fitness Score(Worker &worker, std::string_view genome) {
+        const Fitness fitness = eval.EvaluateBounded(genome, cullBound);
+        worker.stats.evaluated++;
+        if (!ExactFitness(fitness)) worker.stats.culled++;
+        return fitness;
+    }
+
+    // A full evaluation of slot `slot` that keeps its mismatch bitmap for guided mutation (Population::masks)
+    void ScoreWithMask(Worker &worker, Population &population, int slot) {
+        population.diffs[slot] = eval.EvaluateWithMask(population.Genome(slot), population.Mask(slot));
+        population.masked[slot] = 1;
+        worker.stats.evaluated++;
+    }
+
+    // Elite `slot` of nextGeneration - guided mutation reads the bitmap of every mutation parent, so an elite
+    // - that has none (a mutant or random individual of the last generation) is scanned for it here, once
+    void CopyElite(Worker &worker, int slot) {
+        nextGeneration.Copy(slot, generation, ranking[slot]);
+        if (params.mutation == MutationMode::Guided && !nextGeneration.masked[slot]) {
+            ScoreWithMask(worker, nextGeneration, slot);
+        } else {
+            worker.stats.skipped++;
+        }
+    }
+
+    // In deterministic mode the worker's stream is replaced by the one of this child slot
+    void SeedSlot(Worker &worker, int slot) {
+        if (params.deterministic) {
+            worker.rng = GARng::Stream(params.seed, StreamId(generationIndex, slot));
         }
     }
 
@@ -97,220 +580,2357 @@ struct GA {
         }
     }
 
+    // One logical generation is split over all workers of the executor
+    // - loop 1: elites + crossovers, loop 2: mutants + random individuals
+    // - every child goes into its own slot, children are scored as they are made
+    // - mutants read crossover children, so they run in a second loop
+    // - loop 3 moves the best eliteCount of every worker's (fitness, slot) list to its front
+    // - and MergeRanking() turns those into the ranking of the swapped generation
     void Run(int maxGenerations) {
-        
-        std::vector<std::thread> threads;
-        if(numOfThreads == -1) {
-            numOfThreads = std::thread::hardware_concurrency();
-            if(numOfThreads == 0) {
-                numOfThreads = 1;
+        Executor &executor = Exec();
+        const int crossOverEnd = params.eliteCount + params.crossOverCount;
+        const int mutatedEnd = crossOverEnd + params.mutatedCount;
+
+        RankIndividuals();
+        latency.samples.clear();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int c = 0; c < maxGenerations; c++) {
+            for (Worker &worker : workers) {
+                worker.stats = GenerationStats();
+                worker.candidates.clear();
             }
+            int width = RunPhase(Phase::CrossOver, crossOverEnd, [&](int w, int first, int last) {
+                Worker &worker = workers[w];
+                for (int slot = first; slot < last; slot++) {
+                    SeedSlot(worker, slot);
+                    if (slot < params.eliteCount) {
+                        CopyElite(worker, slot);
+                    } else {
+                        const int a = Bounded(worker.rng, generation.Size());
+                        const int b = Bounded(worker.rng, generation.Size());
+                        CrossOver(worker, generation, a, b, nextGeneration, slot);
+                    }
+                    worker.candidates.push_back({ nextGeneration.diffs[slot], slot });
+                }
+            });
+
+            // The elites are copied into nextGeneration, so a child worse than all of them can't be one
+            // - only from here on: the crossover children are the mutants' parents and stay exact,
+            // - so every mutant can be delta evaluated
+            cullBound = CullBound();
+            width = std::max(width, RunPhase(Phase::Mutate, nextGeneration.Size() - crossOverEnd, [&](int w, int first, int last) {
+                Worker &worker = workers[w];
+                for (int slot = crossOverEnd + first; slot < crossOverEnd + last; slot++) {
+                    SeedSlot(worker, slot);
+                    if (slot < mutatedEnd) {
+                        Mutate(worker, nextGeneration, Bounded(worker.rng, crossOverEnd), nextGeneration, slot);
+                    } else {
+                        RandomIndividual(worker, nextGeneration, slot);
+                    }
+                    if (!nextGeneration.Evaluated(slot)) {
+                        nextGeneration.diffs[slot] = Score(worker, nextGeneration.Genome(slot));
+                    }
+                    worker.candidates.push_back({ nextGeneration.diffs[slot], slot });
+                }
+            }));
+
+            // A backend may hand one worker several ranges, so this is done once per worker afterwards
+            const int threads = executor.Workers();
+            executor.ParallelFor(threads, width, [&](int, int first, int last) {
+                for (int w = first; w < last; w++) {
+                    std::vector<RankKey> &candidates = workers[w].candidates;
+                    const int k = std::min<int>(params.eliteCount, candidates.size());
+                    std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end());
+                }
+            });
+
+            std::swap(generation, nextGeneration);
+            generationIndex++;
+            cullBound = kUnknownFitness;
+            MergeRanking(threads);
+            auto end = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+            start = end;
+            latency.Add(duration);
+            if (params.verbose && c % 1000 == 0)
+                std::cout << generation.diffs[ranking[0]] << "version: " << c << ": " << generation.Genome(ranking[0]) << std::endl;
+            if (params.verbose && c % 100 == 0) PrintStats(duration);
         }
-        int generationChunk = maxGenerations / numOfThreads;
-        int generationChunkOffset = maxGenerations % numOfThreads;
-        for(int t = 0; t < numOfThreads; t++) {
-            
-            if(t == numOfThreads - 1) generationChunk += generationChunkOffset;
-            threads.emplace_back([this, &generationChunk]{
-            for (int c = 0; c < generationChunk; c++) {
-                std::lock_guard<std::mutex> lock(mtx);
+        if (params.verbose) PrintLatency();
+    }
 
-                std::vector<Individual> nextGeneration;
-                auto start = std::chrono::high_resolution_clock::now();
-                RankIndividuals();
+    // Builds the ranking of the (just swapped in) generation from the workers' candidates
+    // - with RankMode::TopK only the best eliteCount of every worker can be an elite
+    void MergeRanking(int threads) {
+        if (params.rankMode != RankMode::TopK) {
+            OrderRanking();
+            return;
+        }
+        rankKeys.clear();
+        for (int w = 0; w < threads; w++) {
+            const int k = std::min<int>(params.eliteCount, workers[w].candidates.size());
+            rankKeys.insert(rankKeys.end(), workers[w].candidates.begin(), workers[w].candidates.begin() + k);
+        }
+        const int k = std::min<int>(params.eliteCount, rankKeys.size());
+        std::nth_element(rankKeys.begin(), rankKeys.begin() + k, rankKeys.end());
+        std::sort(rankKeys.begin(), rankKeys.begin() + k);
+        ranking.resize(k);
+        for (int c = 0; c < k; c++) {
+            ranking[c] = rankKeys[c].index;
+        }
+    }
 
-                if (c % 1000 == 0)
-                    std::cout << generation[0].diff << "version: " << c << ": " << generation[0].data << std::endl;
-                nextGeneration.reserve(generation.size());
+    // Pipelined generations - the pool is split into breeders and evaluators
+    // - breeders write children in batches of about kPipelineBatchBytes of genomes (so a batch is
+    // - still in cache when it is scored) and hand [first, last) slot ranges over a BoundedQueue
+    // - evaluators score the batches while the breeders already make the next ones
+    // - phase 1: elites + crossover genomes (scored by the evaluators)
+    // - phase 2: mutants, scored by delta right away by the breeders since their crossover sources are
+    // - scored by then, and random individuals (scored by the evaluators)
+    // - the end of a phase is one {-1, -1} marker per evaluator, then everyone meets at the barrier
+    // - with a pool of 1 there is nobody to overlap with, so this is just Run()
+    static constexpr int kPipelineBatchBytes = 32 << 10;
 
-                for (int index = 0; index < params.eliteCount; index++) {
-                    nextGeneration.push_back(generation[index]);
+    void RunPipelined(int maxGenerations) {
+        WorkerPool &workerPool = Pool();
+        const int threads = workerPool.Size();
+        if (threads == 1) {
+            Run(maxGenerations);
+            return;
+        }
+        const int evaluators = threads / 2;
+        const int breeders = threads - evaluators;
+        const int batch = std::max(1, kPipelineBatchBytes / generation.stride);
+        const int crossOverEnd = params.eliteCount + params.crossOverCount;
+        const int mutatedEnd = crossOverEnd + params.mutatedCount;
+        Barrier barrier(threads);
+        Barrier breederBarrier(breeders);
+        BoundedQueue<std::pair<int, int>> queue(4 * evaluators);
+
+        RankIndividuals();
+        latency.samples.clear();
+        workerPool.Run([&](int w) {
+            Worker &worker = workers[w];
+            auto start = std::chrono::high_resolution_clock::now();
+            // Breeders make the batches of [begin, end) that fall on them, evaluators score what they get
+            auto phase = [&](int begin, int end, auto &&breed) {
+                if (w < breeders) {
+                    const int batches = (end - begin + batch - 1) / batch;
+                    const auto [first, last] = ChunkOf(batches, w, breeders);
+                    for (int b = first; b < last; b++) {
+                        const int from = begin + b * batch, to = std::min(end, from + batch);
+                        for (int slot = from; slot < to; slot++) {
+                            SeedSlot(worker, slot);
+                            breed(slot);
+                        }
+                        queue.Push({ from, to });
+                    }
+                    breederBarrier.Wait();
+                    if (w == 0) {
+                        for (int e = 0; e < evaluators; e++) queue.Push({ -1, -1 });
+                    }
+                } else {
+                    for (auto [from, to] = queue.Pop(); from >= 0; std::tie(from, to) = queue.Pop()) {
+                        for (int slot = from; slot < to; slot++) {
+                            if (!nextGeneration.Evaluated(slot)) {
+                                nextGeneration.diffs[slot] = eval.Evaluate(nextGeneration.Genome(slot));
+                                worker.stats.evaluated++;
+                            }
+                            worker.candidates.push_back({ nextGeneration.diffs[slot], slot });
+                        }
+                    }
                 }
+                barrier.Wait();
+            };
+
+            for (int c = 0; c < maxGenerations; c++) {
+                worker.stats = GenerationStats();
+                worker.candidates.clear();
+                phase(0, crossOverEnd, [&](int slot) {
+                    if (slot < params.eliteCount) {
+                        CopyElite(worker, slot);
+                    } else {
+                        const int a = Bounded(worker.rng, generation.Size());
+                        const int b = Bounded(worker.rng, generation.Size());
+                        CrossOverGenome(worker, generation, a, b, nextGeneration, slot);
+                        nextGeneration.diffs[slot] = kUnknownFitness;
+                    }
+                });
+                phase(crossOverEnd, nextGeneration.Size(), [&](int slot) {
+                    if (slot < mutatedEnd) {
+                        Mutate(worker, nextGeneration, Bounded(worker.rng, crossOverEnd), nextGeneration, slot);
+                    } else {
+                        RandomIndividual(worker, nextGeneration, slot);
+                    }
+                });
+                const int k = std::min<int>(params.eliteCount, worker.candidates.size());
+                std::nth_element(worker.candidates.begin(), worker.candidates.begin() + k, worker.candidates.end());
+                barrier.Wait();
 
-                for (int index = 0; index < params.crossOverCount; index++) {
-                    std::uniform_int_distribution<int> individualPicker(0, generation.size() - 1);
-                    const Individual &a = generation[individualPicker(rng)];
-                    const Individual &b = generation[individualPicker(rng)];
-                    nextGeneration.push_back(CrossOver(a, b));
+                if (w == 0) {
+                    std::swap(generation, nextGeneration);
+                    generationIndex++;
+                    MergeRanking(threads);
+                    auto end = std::chrono::high_resolution_clock::now();
+                    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+                    start = end;
+                    latency.Add(duration);
+                    if (params.verbose && c % 1000 == 0)
+                        std::cout << generation.diffs[ranking[0]] << " pipelined: " << c << ": " << generation.Genome(ranking[0]) << std::endl;
+                    if (params.verbose && c % 100 == 0) PrintStats(duration);
                 }
+                barrier.Wait();
+            }
+        });
+        if (params.verbose) PrintLatency();
+    }
 
-                std::uniform_int_distribution<int> individualPicker(0, nextGeneration.size() - 1);
-                for (int index = 0; index < params.mutatedCount; index++) {
-                    const Individual &source = nextGeneration[individualPicker(rng)];
-                    nextGeneration.push_back(Mutate(source));
+    // TBB backend - the same generation as Run(), written with TBB algorithms instead of the pool
+    // - runs in a task_arena of Threads() threads, breeding and scoring are tbb::parallel_for loops
+    // - the per-thread Worker (random stream, scratch buffers, stats) is an enumerable_thread_specific
+    // - elites come from tbb::parallel_reduce of per-range top-k lists (TbbRanking())
+    // - the stats of a generation are summed over the thread-local workers
+    void RunTbb(int maxGenerations) {
+        const int crossOverEnd = params.eliteCount + params.crossOverCount;
+        const int mutatedEnd = crossOverEnd + params.mutatedCount;
+        std::atomic<uint64_t> streams{ 0 };
+        tbb::enumerable_thread_specific<Worker> locals([&] { return MakeWorker(GARng::Stream(params.seed, streams++)); });
+        // TBB caps its threads at the core count unless told otherwise - numOfThreads wins, as for the pool
+        tbb::global_control control(tbb::global_control::max_allowed_parallelism, Threads());
+        tbb::task_arena arena(Threads());
+        latency.samples.clear();
+
+        arena.execute([&] {
+            tbb::parallel_for(tbb::blocked_range<int>(0, generation.Size()), [&](const tbb::blocked_range<int> &range) {
+                GenerationStats &stats = locals.local().stats;
+                for (int slot = range.begin(); slot < range.end(); slot++) {
+                    if (generation.Evaluated(slot)) continue;
+                    generation.diffs[slot] = eval.Evaluate(generation.Genome(slot));
+                    stats.evaluated++;
                 }
+            });
+            TbbRanking();
+
+            for (int c = 0; c < maxGenerations; c++) {
+                auto start = std::chrono::high_resolution_clock::now();
+                for (Worker &worker : locals) worker.stats = GenerationStats();
+                tbb::parallel_for(tbb::blocked_range<int>(0, crossOverEnd), [&](const tbb::blocked_range<int> &range) {
+                    Worker &worker = locals.local();
+                    for (int slot = range.begin(); slot < range.end(); slot++) {
+                        SeedSlot(worker, slot);
+                        if (slot < params.eliteCount) {
+                            CopyElite(worker, slot);
+                        } else {
+                            const int a = Bounded(worker.rng, generation.Size());
+                            const int b = Bounded(worker.rng, generation.Size());
+                            CrossOver(worker, generation, a, b, nextGeneration, slot);
+                        }
+                    }
+                });
+                // Mutants and random individuals are culled as in Run()
+                cullBound = CullBound();
+                tbb::parallel_for(tbb::blocked_range<int>(crossOverEnd, nextGeneration.Size()), [&](const tbb::blocked_range<int> &range) {
+                    Worker &worker = locals.local();
+                    for (int slot = range.begin(); slot < range.end(); slot++) {
+                        SeedSlot(worker, slot);
+                        if (slot < mutatedEnd) {
+                            Mutate(worker, nextGeneration, Bounded(worker.rng, crossOverEnd), nextGeneration, slot);
+                        } else {
+                            RandomIndividual(worker, nextGeneration, slot);
+                        }
+                        if (!nextGeneration.Evaluated(slot)) {
+                            nextGeneration.diffs[slot] = Score(worker, nextGeneration.Genome(slot));
+                        }
+                    }
+                });
+                std::swap(generation, nextGeneration);
+                generationIndex++;
+                cullBound = kUnknownFitness;
+                TbbRanking();
 
-                while (nextGeneration.size() < params.generationSize) {
-                    nextGeneration.push_back(RandomIndividual());
+                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+                latency.Add(duration);
+                if (params.verbose && c % 1000 == 0)
+                    std::cout << generation.diffs[ranking[0]] << " tbb: " << c << ": " << generation.Genome(ranking[0]) << std::endl;
+                if (params.verbose && c % 100 == 0) {
+                    GenerationStats stats;
+                    for (const Worker &worker : locals) {
+                        stats.evaluated += worker.stats.evaluated;
+                        stats.deltaEvaluated += worker.stats.deltaEvaluated;
+                        stats.skipped += worker.stats.skipped;
+                        stats.culled += worker.stats.culled;
+                    }
+                    PrintStats(duration, stats);
                 }
+            }
+        });
+        if (params.verbose) PrintLatency();
+    }
 
-                this->generation.swap(nextGeneration);
-                //nextGeneration.clear();
-                auto end = std::chrono::high_resolution_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-                if(c % 100 == 0) std::cout << "Duration (us): " << duration.count() << std::endl;
+    // With RankMode::TopK every range keeps its eliteCount best and two lists are joined the same way
+    // - the other modes sort all (fitness, slot) pairs with tbb::parallel_sort
+    void TbbRanking() {
+        const int k = std::min(params.eliteCount, generation.Size());
+        if (params.rankMode == RankMode::TopK) {
+            auto keepBest = [k](std::vector<RankKey> &keys) {
+                if (int(keys.size()) > k) {
+                    std::nth_element(keys.begin(), keys.begin() + k, keys.end());
+                    keys.resize(k);
+                }
+            };
+            std::vector<RankKey> best = tbb::parallel_reduce(
+                tbb::blocked_range<int>(0, generation.Size()), std::vector<RankKey>(),
+                [&](const tbb::blocked_range<int> &range, std::vector<RankKey> keys) {
+                    for (int slot = range.begin(); slot < range.end(); slot++) {
+                        keys.push_back({ generation.diffs[slot], slot });
+                    }
+                    keepBest(keys);
+                    return keys;
+                },
+                [&](std::vector<RankKey> a, const std::vector<RankKey> &b) {
+                    a.insert(a.end(), b.begin(), b.end());
+                    keepBest(a);
+                    return a;
+                });
+            std::sort(best.begin(), best.end());
+            ranking.resize(best.size());
+            for (int c = 0; c < best.size(); c++) {
+                ranking[c] = best[c].index;
             }
-            });
+            return;
+        }
+        FillRankKeys();
+        tbb::parallel_sort(rankKeys.begin(), rankKeys.end());
+        ranking.resize(rankKeys.size());
+        for (int c = 0; c < rankKeys.size(); c++) {
+            ranking[c] = rankKeys[c].index;
         }
-    for(auto &th : threads) th.join();
     }
 
+    // Only the crossovers run in parallel here, on the same executor as Run()
+    // - mutants and random individuals are still made by worker 0 alone
     void RunWithP(int maxGenerations) {
-        std::vector<Individual> nextGeneration;
+        latency.samples.clear();
         for (int c = 0; c < maxGenerations; c++) {
             auto start = std::chrono::high_resolution_clock::now();
+            for (Worker &worker : workers) worker.stats = GenerationStats();
             RankIndividuals();
 
-            if (c % 1000 == 0)
-                std::cout << generation[0].diff << ": " << generation[0].data << std::endl;
-            nextGeneration.reserve(generation.size());
+            if (params.verbose && c % 1000 == 0)
+                std::cout << generation.diffs[ranking[0]] << ": " << generation.Genome(ranking[0]) << std::endl;
 
             for (int index = 0; index < params.eliteCount; index++) {
-                nextGeneration.push_back(generation[index]);
+                CopyElite(workers[0], index);
             }
-
-            std::vector<std::thread> threads;
-            int chunkSizeC = params.crossOverCount / numOfThreads;
-            int cOffset = params.crossOverCount % numOfThreads;
-            int chunkSizeM = params.mutatedCount / numOfThreads;
-            int mOffset = params.mutatedCount % numOfThreads;
-
-            for(int t = 0; t < numOfThreads; t++) {
-                if(t == numOfThreads-1) {
-                    chunkSizeC += cOffset;
-                    chunkSizeM += mOffset;
+            // Every worker writes its crossovers into its own range of slots
+            RunPhase(Phase::CrossOver, params.crossOverCount, [&](int w, int first, int last) {
+                Worker &worker = workers[w];
+                for (int index = first; index < last; index++) {
+                    SeedSlot(worker, params.eliteCount + index);
+                    const int a = Bounded(worker.rng, generation.Size());
+                    const int b = Bounded(worker.rng, generation.Size());
+                    CrossOver(worker, generation, a, b, nextGeneration, params.eliteCount + index);
                 }
-                threads.emplace_back([this, &chunkSizeC, &chunkSizeM, &nextGeneration]() {
-                    std::lock_guard<std::mutex> lock(mtx);
-                    for (int index = 0; index < chunkSizeC; index++) {
-                        std::uniform_int_distribution<int> individualPicker(0, generation.size() - 1);
-                        const Individual &a = generation[individualPicker(rng)];
-                        const Individual &b = generation[individualPicker(rng)];
-                        nextGeneration.push_back(CrossOver(a, b));
-                    }
+            });
 
-                });
-            }
-            for(auto &th : threads) {
-                th.join();
-            }
-            std::uniform_int_distribution<int> individualPicker(0, nextGeneration.size() - 1);
+            // Mutants and random individuals can be culled, the crossovers (their parents) are exact, as in Run()
+            cullBound = CullBound();
+            Worker &worker = workers[0];
+            int filled = params.eliteCount + params.crossOverCount;
+            const int mutationSources = filled;
             for (int index = 0; index < params.mutatedCount; index++) {
-                const Individual &source = nextGeneration[individualPicker(rng)];
-                nextGeneration.push_back(Mutate(source));
+                SeedSlot(worker, filled);
+                Mutate(worker, nextGeneration, Bounded(worker.rng, mutationSources), nextGeneration, filled++);
             }
-            while (nextGeneration.size() < params.generationSize) {
-                nextGeneration.push_back(RandomIndividual());
+            while (filled < nextGeneration.Size()) {
+                SeedSlot(worker, filled);
+                RandomIndividual(worker, nextGeneration, filled++);
             }
 
-            generation.swap(nextGeneration);
-            nextGeneration.clear();
+            std::swap(generation, nextGeneration);
+            generationIndex++;
+            cullBound = kUnknownFitness;
             auto end = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-            if(c % 100 == 0) std::cout << "Duration (us): " << duration.count() << std::endl;
+            latency.Add(duration);
+            if(params.verbose && c % 100 == 0) PrintStats(duration);
         }
+        if (params.verbose) PrintLatency();
     }
-/*
-    void RankIndividuals() {
-        if(numOfThreads == -1) {
-            numOfThreads = std::thread::hardware_concurrency();
-            if(numOfThreads == 0) {
-                numOfThreads = 1;
-            }
-        }
 
-        std::vector<std::thread> threads;
-        int chunkSize = generation.size() / numOfThreads;
+    // Cellular mode - generation is a rows x cols torus (GridShape()) and mates are local
+    // - every cell crosses over with the better of two random cells of its N/S/E/W neighbours
+    // - (or is mutated / replaced by a random individual, in the proportions of a generation)
+    // - and the child takes the cell in nextGeneration only if it is better than the old one
+    // - worker w owns a band of rows, so it only reads the row above and below its band from other
+    // - workers - those halo rows are read in place, the previous generation is read-only until the swap
+    // - the band is walked in column blocks whose 3 rows of genomes fit in L2
+    void RunCellular(int maxGenerations) {
+        WorkerPool &workerPool = Pool();
+        const int threads = workerPool.Size();
+        Barrier barrier(threads);
+        const auto [rows, cols] = GridShape(generation.Size());
+        const int blockCols = std::clamp(int((256 << 10) / (3 * generation.stride)), 1, cols);
+        const uint32_t kinds = std::max(1, generation.Size() - params.eliteCount);
+        const uint32_t mutatedFrom = params.crossOverCount;
+        const uint32_t randomFrom = mutatedFrom + params.mutatedCount;
 
-        for (int t = 0; t < numOfThreads; t++) {
-            int start = t * chunkSize;
-            int end = (t == numOfThreads - 1) ? generation.size() : (t + 1) * chunkSize;
+        RankIndividuals();
+        latency.samples.clear();
+        workerPool.Run([&](int w) {
+            Worker &worker = workers[w];
+            const auto [firstRow, lastRow] = ChunkOf(rows, w, threads);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int g = 0; g < maxGenerations; g++) {
+                worker.stats = GenerationStats();
+                worker.candidates.clear();
+                for (int firstCol = 0; firstCol < cols; firstCol += blockCols) {
+                    const int lastCol = std::min(cols, firstCol + blockCols);
+                    for (int row = firstRow; row < lastRow; row++) {
+                        for (int col = firstCol; col < lastCol; col++) {
+                            const int slot = row * cols + col;
+                            const uint32_t kind = Bounded(worker.rng, kinds);
+                            if (kind >= randomFrom) {
+                                RandomIndividual(worker, nextGeneration, slot);
+                            } else if (kind >= mutatedFrom) {
+                                Mutate(worker, generation, slot, nextGeneration, slot);
+                            } else {
+                                const int neighbours[4] = { (row + rows - 1) % rows * cols + col, (row + 1) % rows * cols + col,
+                                                            row * cols + (col + cols - 1) % cols, row * cols + (col + 1) % cols };
+                                const int a = neighbours[Bounded(worker.rng, 4)];
+                                const int b = neighbours[Bounded(worker.rng, 4)];
+                                const int mate = generation.diffs[b] < generation.diffs[a] ? b : a;
+                                CrossOver(worker, generation, slot, mate, nextGeneration, slot);
+                            }
+                            if (!nextGeneration.Evaluated(slot)) {
+                                nextGeneration.diffs[slot] = eval.Evaluate(nextGeneration.Genome(slot));
+                                worker.stats.evaluated++;
+                            }
+                            if (nextGeneration.diffs[slot] >= generation.diffs[slot]) {
+                                nextGeneration.Copy(slot, generation, slot);
+                            }
+                            worker.candidates.push_back({ nextGeneration.diffs[slot], slot });
+                        }
+                    }
+                }
+                const int k = std::min<int>(params.eliteCount, worker.candidates.size());
+                std::nth_element(worker.candidates.begin(), worker.candidates.begin() + k, worker.candidates.end());
+                barrier.Wait();
 
-            threads.emplace_back([this, start, end]() {
-                for (int i = start; i < end; i++) {
-                    generation[i].diff = eval.Evaluate(generation[i].data);
+                if (w == 0) {
+                    std::swap(generation, nextGeneration);
+                    generationIndex++;
+                    MergeRanking(threads);
+                    auto end = std::chrono::high_resolution_clock::now();
+                    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+                    start = end;
+                    latency.Add(duration);
+                    if (params.verbose && g % 1000 == 0)
+                        std::cout << generation.diffs[ranking[0]] << " cellular: " << g << ": " << generation.Genome(ranking[0]) << std::endl;
+                    if (params.verbose && g % 100 == 0) PrintStats(duration);
                 }
-            });
-        }
+                barrier.Wait();
+                if (generation.diffs[ranking[0]] == 0) break;
+            }
+        });
+        if (params.verbose) PrintLatency();
+    }
 
-        for (auto &t : threads) {
-            t.join();
+    // Steady-state mode - no generations, no swap and no barrier to wait at
+    // - every worker breeds one child at a time from parents copied out of generation
+    // - the kind of child (crossover, mutant, random) is drawn in the proportions of a generation
+    // - the child replaces a random slot if it is better, so the best individual is never lost
+    // - stops at fitness 0 or after maxEvaluations children in total, which it returns
+    long long RunSteadyState(long long maxEvaluations) {
+        WorkerPool &workerPool = Pool();
+        const int threads = workerPool.Size();
+        RankIndividuals();
+        if (slotVersionCount != generation.Size()) {
+            slotVersionCount = generation.Size();
+            slotVersions = std::make_unique<std::atomic<uint32_t>[]>(slotVersionCount);
         }
+        bestFitness.store(generation.diffs[ranking[0]]);
+        const uint32_t kinds = std::max(1, generation.Size() - params.eliteCount);
+        const uint32_t mutatedFrom = params.crossOverCount;
+        const uint32_t randomFrom = mutatedFrom + params.mutatedCount;
+        std::atomic<long long> made{ 0 };
+        auto start = std::chrono::high_resolution_clock::now();
 
-        std::sort(generation.begin(), generation.end(), [this](const Individual &a, const Individual &b) {
-            return a.diff < b.diff;
+        workerPool.Run([&](int w) {
+            Worker &worker = workers[w];
+            Population &scratch = worker.scratch;
+            if (scratch.Size() != 3 || scratch.stride != generation.stride) scratch.Resize(3, generation.stride);
+            worker.stats = GenerationStats();
+            const long long quota = maxEvaluations * (w + 1) / threads - maxEvaluations * w / threads;
+            long long c = 0;
+            for (; c < quota && bestFitness.load(std::memory_order_relaxed) != 0; c++) {
+                const uint32_t kind = Bounded(worker.rng, kinds);
+                if (kind >= randomFrom) {
+                    RandomIndividual(worker, scratch, 2);
+                    scratch.diffs[2] = eval.Evaluate(scratch.Genome(2));
+                    worker.stats.evaluated++;
+                } else {
+                    ReadSlot(Bounded(worker.rng, generation.Size()), scratch, 0);
+                    if (kind >= mutatedFrom) {
+                        Mutate(worker, scratch, 0, scratch, 2);
+                    } else {
+                        ReadSlot(Bounded(worker.rng, generation.Size()), scratch, 1);
+                        CrossOver(worker, scratch, 0, 1, scratch, 2);
+                    }
+                    // The mutant of a parent that the last Run() culled is scored in full
+                    if (!scratch.Evaluated(2)) scratch.diffs[2] = Score(worker, scratch.Genome(2));
+                }
+                if (TryReplace(Bounded(worker.rng, generation.Size()), scratch, 2)) {
+                    Fitness current = bestFitness.load(std::memory_order_relaxed);
+                    while (scratch.diffs[2] < current && !bestFitness.compare_exchange_weak(current, scratch.diffs[2], std::memory_order_relaxed)) {}
+                }
+                if (params.verbose && w == 0 && c % 100'000 == 0) {
+                    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+                    std::cout << bestFitness.load(std::memory_order_relaxed) << " children: " << c * threads << " (us): " << elapsed.count() << std::endl;
+                }
+            }
+            made.fetch_add(c, std::memory_order_relaxed);
         });
+        // Back to a normal ranked generation, so Run() can continue from here
+        RankIndividuals();
+        return made.load();
+    }
+
+    // Copies slot `slot` of generation into `to` without locking it
+    // - the copy is only kept if the slot's version was even and the same before and after
+    void ReadSlot(int slot, Population &to, int toSlot) {
+        std::atomic<uint32_t> &version = slotVersions[slot];
+        while (true) {
+            const uint32_t before = version.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            // Length, genome and fitness may belong to different versions - that is caught by the version check
+            const int length = RelaxedLoad(generation.lengths[slot]);
+            RelaxedCopy(to.Data(toSlot), generation.Data(slot), length);
+            const Fitness diff = RelaxedLoad(generation.diffs[slot]);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) == before) {
+                to.lengths[toSlot] = length;
+                to.diffs[toSlot] = diff;
+                to.masked[toSlot] = 0;
+                return;
+            }
+        }
+    }
+
+    // Writes the child over slot `slot` of generation if it is better
+    // - a slot that another writer owns right now is left alone (the child is dropped)
+    bool TryReplace(int slot, const Population &from, int fromSlot) {
+        std::atomic<uint32_t> &version = slotVersions[slot];
+        uint32_t current = version.load(std::memory_order_relaxed);
+        if ((current & 1) || !version.compare_exchange_strong(current, current + 1, std::memory_order_acquire)) {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        // The slot has no other writer now, only readers
+        const bool better = from.diffs[fromSlot] < generation.diffs[slot];
+        if (better) {
+            RelaxedCopy(generation.Data(slot), from.Data(fromSlot), from.lengths[fromSlot]);
+            RelaxedStore(generation.lengths[slot], from.lengths[fromSlot]);
+            RelaxedStore(generation.diffs[slot], from.diffs[fromSlot]);
+            generation.masked[slot] = 0;
+        }
+        version.store(current + 2, std::memory_order_release);
+        return better;
     }
-*/
 
+    void PrintLatency() {
+        std::cout << "Generation latency (us): p50 " << latency.Percentile(0.5)
+                  << " p90 " << latency.Percentile(0.9)
+                  << " p99 " << latency.Percentile(0.99)
+                  << " max " << latency.Percentile(1.0) << std::endl;
+    }
+
+    // Only individuals without a known fitness are evaluated
+    // - CrossOver() and Mutate() score their children as they make them
+    // - the genomes never move, only the ranking (an index view) is ordered
+    // - the evaluation is split into chunks over the executor
+    // - every chunk scores its unevaluated slots with one EvaluateBatch() call
+    // - with params.cull the eliteCount-th best exact fitness already known bounds the others
+    // - guided mutation wants the bitmaps of the slots, so without a bound they are scored one by one with them
     void RankIndividuals() {
-        for (int c = 0; c < generation.size(); c++) {
-            generation[c].diff = eval.Evaluate(generation[c].data);
+        Fitness bound = kUnknownFitness;
+        if (params.cull && params.eliteCount > 0) {
+            boundScratch.clear();
+            for (int c = 0; c < generation.Size(); c++) {
+                if (ExactFitness(generation.diffs[c])) boundScratch.push_back(generation.diffs[c]);
+            }
+            if (int(boundScratch.size()) >= params.eliteCount) {
+                std::nth_element(boundScratch.begin(), boundScratch.begin() + params.eliteCount - 1, boundScratch.end());
+                bound = boundScratch[params.eliteCount - 1];
+            }
         }
-        std::sort(std::execution::par_unseq, generation.begin(), generation.end(), [this](const Individual &a, const Individual &b) {
-            return a.diff < b.diff;
+        RunPhase(Phase::Evaluate, generation.Size(), [&](int w, int first, int last) {
+            Worker &worker = workers[w];
+            worker.batchSlots.clear();
+            for (int c = first; c < last; c++) {
+                if (generation.Evaluated(c)) {
+                    worker.stats.skipped++;
+                } else if (params.mutation == MutationMode::Guided && bound == kUnknownFitness) {
+                    ScoreWithMask(worker, generation, c);
+                } else {
+                    worker.batchSlots.push_back(c);
+                }
+            }
+            const size_t count = worker.batchSlots.size();
+            worker.batchFitness.resize(count);
+            const Fitness *fitness = eval.EvaluateBatch(generation.Data(0), generation.stride, generation.lengths.data(),
+                                                        worker.batchSlots.data(), count, worker.batchFitness.data(), bound);
+            for (size_t i = 0; i < count; i++) {
+                generation.diffs[worker.batchSlots[i]] = fitness[i];
+                if (!ExactFitness(fitness[i])) worker.stats.culled++;
+            }
+            worker.stats.evaluated += int(count);
         });
+        OrderRanking();
+    }
+
+    void OrderRanking() {
+        if (params.rankMode == RankMode::TopK) {
+            SelectElites();
+            return;
+        }
+        if (params.rankMode == RankMode::RadixSort && RadixSortRanking()) {
+            return;
+        }
+        SortRanking();
     }
 
-    Individual CrossOver(const Individual &a, const Individual &b) {
-        const int newLen = (a.data.size() + b.data.size()) / 2;
-        Individual result = a.data.size() > b.data.size() ? a : b;
-        result.data.resize(newLen);
-        std::discrete_distribution<> parentChooser({ double(2 + b.diff), double(2 + a.diff) });
-        const Individual *parentChoose[2] = { &a, &b };
+    void FillRankKeys() {
+        rankKeys.clear();
+        for (int c = 0; c < generation.Size(); c++) {
+            rankKeys.push_back({ generation.diffs[c], c });
+        }
+    }
 
-        for (int c = 0; c < std::min(a.data.size(), b.data.size()); c++) {
-            result.data[c] = parentChoose[parentChooser(rng)]->data[c];
+    void SortRanking() {
+        FillRankKeys();
+        std::sort(std::execution::par_unseq, rankKeys.begin(), rankKeys.end());
+        ranking.resize(rankKeys.size());
+        for (int c = 0; c < rankKeys.size(); c++) {
+            ranking[c] = rankKeys[c].index;
         }
-        return result;
     }
 
-    Individual Mutate(const Individual &source) {
-        Individual mutated = source;
+    // Sorts packed (fitness >> 8, index) keys
+    // - the low byte of a fitness is 0 but for the kBoundedFitness flag, which >> 8 discards
+    // - a culled value is > the bound it lost to, so without the flag it still orders after every elite
+    // - returns false if a fitness doesn't fit next to the index bits
+    bool RadixSortRanking() {
+        int indexBits = 1;
+        while ((size_t(1) << indexBits) < generation.Size()) indexBits++;
+        const Fitness maxFitness = (std::numeric_limits<uint64_t>::max() >> indexBits) << 8;
+
+        packedKeys.clear();
+        for (int c = 0; c < generation.Size(); c++) {
+            if (generation.diffs[c] > maxFitness) return false;
+            packedKeys.push_back(((generation.diffs[c] >> 8) << indexBits) | uint64_t(c));
+        }
+        RadixSort(packedKeys, packedScratch);
+
+        const uint64_t indexMask = (uint64_t(1) << indexBits) - 1;
+        ranking.resize(packedKeys.size());
+        for (int c = 0; c < packedKeys.size(); c++) {
+            ranking[c] = int(packedKeys[c] & indexMask);
+        }
+        return true;
+    }
+
+    // Orders only the eliteCount best - selection runs on the compact (fitness, index) array
+    void SelectElites() {
+        const int k = std::min(params.eliteCount, generation.Size());
+        FillRankKeys();
+        std::nth_element(rankKeys.begin(), rankKeys.begin() + k, rankKeys.end());
+        std::sort(rankKeys.begin(), rankKeys.begin() + k);
+        ranking.resize(k);
+        for (int c = 0; c < k; c++) {
+            ranking[c] = rankKeys[c].index;
+        }
+    }
+
+    // The child is written into slot `slot` of `to`
+    void CrossOver(Worker &worker, const Population &from, int a, int b, Population &to, int slot) {
+        CrossOverGenome(worker, from, a, b, to, slot);
+        // The child is hot in cache right now and its fitness is needed if it gets mutated
+        // - guided mutation needs its bitmap too, which the same scan gives (crossovers are never culled)
+        if (params.mutation == MutationMode::Guided && cullBound == kUnknownFitness) {
+            ScoreWithMask(worker, to, slot);
+        } else {
+            to.diffs[slot] = Score(worker, to.Genome(slot));
+        }
+    }
+
+    // Each char in the common part comes from a with chance (2 + diff b) / (4 + diff a + diff b)
+    // - a culled parent weighs in with the lower bound of its fitness
+    // - that chance is turned into a 16-bit threshold, the random numbers are drawn in bulk
+    // - and the child is built with a SIMD blend of the two parents (simd.h)
+    void CrossOverGenome(Worker &worker, const Population &from, int a, int b, Population &to, int slot) {
+        const int lengthA = from.lengths[a];
+        const int lengthB = from.lengths[b];
+        const int newLen = (lengthA + lengthB) / 2;
+        const int common = std::min(lengthA, lengthB);
+        char *result = to.Data(slot);
+        // Past the shorter parent the child is a copy of the longer one
+        std::memcpy(result + common, (lengthA > lengthB ? from.Data(a) : from.Data(b)) + common, newLen - common);
+
+        const double weightA = 2.0 + from.diffs[b];
+        const double weightB = 2.0 + from.diffs[a];
+        const uint32_t threshold = uint32_t(65536.0 * weightA / (weightA + weightB) + 0.5);
+        FillRandom(worker.rng, worker.crossOverRandom.data(), common * sizeof(uint16_t));
+        ActiveKernels().blendBytes(result, from.Data(a), from.Data(b), worker.crossOverRandom.data(), threshold, common);
+        to.lengths[slot] = newLen;
+        to.masked[slot] = 0;
+    }
+
+    // from and to may be the same population as long as source != slot
+    void Mutate(Worker &worker, const Population &from, int source, Population &to, int slot) {
+        GARng &rng = worker.rng;
+        std::vector<int> &mutatedPositions = worker.mutatedPositions;
+        const int sourceLength = from.lengths[source];
+        char *mutated = to.Data(slot);
+
+        // The new length is uniform in 1..individualSize
+        // - guided mutation keeps a length that already equals the target's, like it keeps matching chars
+        int newLength = 1 + Bounded(rng, params.individualSize);
+        if (params.mutation == MutationMode::Guided && sourceLength == int(eval.target.size())) newLength = sourceLength;
+        std::memcpy(mutated, from.Data(source), std::min(sourceLength, newLength));
 
-        std::uniform_real_distribution<float> mutateCheck(0, 1);
-        std::uniform_int_distribution<int> letterDist(0, int(allowedSymbols.size() - 1));
+        if (sourceLength - 1 < newLength) {
+            FillFromAlphabet(rng, mutated + sourceLength - 1, newLength - sourceLength + 1, allowedSymbols.data(), allowedSymbols.size());
+        }
 
-        std::uniform_int_distribution<int> lengthChange(1 - source.data.size(), params.individualSize - source.data.size());
-        const int newLength = lengthChange(rng) + source.data.size();
-        mutated.data.resize(newLength, 'a');
+        // Everything from tailStart on was rewritten (or cut off) above
+        // - only the positions changed before it have to be remembered for EvaluateDelta()
+        const int tailStart = std::min(sourceLength - 1, newLength);
+        Fitness sourceFitness = from.diffs[source];
+        if (params.mutation == MutationMode::Guided) {
+            // The mismatches of the copied prefix - past the target every char is as wrong as any other
+            // - the bitmap was kept when the parent was scored (CrossOver(), CopyElite(), RankIndividuals())
+            const int prefix = std::min<int>(tailStart, eval.target.size());
+            const uint64_t *mask = from.Mask(source);
+            if (!from.masked[source]) {
+                // A parent scored without one (e.g. by another engine) is scanned here - that scan also gives
+                // - its exact fitness, so the child can still be delta evaluated
+                sourceFitness = eval.EvaluateWithMask(from.Genome(source), worker.mismatchMask.data());
+                worker.stats.evaluated++;
+                mask = worker.mismatchMask.data();
+            }
+            SampleMismatchedPositions(rng, mask, prefix, mutatedPositions);
+        } else {
+            SampleMutatedPositions(rng, newLength, mutatedPositions);
+        }
+        for (int c : mutatedPositions) {
+            mutated[c] = allowedSymbols[Bounded(rng, allowedSymbols.size())];
+        }
+        mutatedPositions.erase(std::lower_bound(mutatedPositions.begin(), mutatedPositions.end(), tailStart), mutatedPositions.end());
 
-        for (int c = source.data.size() - 1; c < mutated.data.size(); c++) {
-            mutated.data[c] = allowedSymbols[letterDist(rng)];
+        to.lengths[slot] = newLength;
+        to.masked[slot] = 0;
+        // A culled parent has no exact fitness to start from - the caller scores the child in full
+        to.diffs[slot] = kUnknownFitness;
+        if (ExactFitness(sourceFitness)) {
+            to.diffs[slot] = eval.EvaluateDelta(from.Genome(source), sourceFitness, to.Genome(slot), mutatedPositions, tailStart);
+            worker.stats.deltaEvaluated++;
         }
+    }
+
+    // Every set bit of mask below length is picked with chance mutationRate - at least one if there is any
+    // - the gaps are drawn by SampleMutatedPositions() in units of mismatches, then turned into positions
+    // - by walking the words once, so the cost is O(words + picked positions)
+    // - mask is only read, its bits from length on are ignored
+    void SampleMismatchedPositions(GARng &rng, const uint64_t *mask, int length, std::vector<int> &positions) {
+        const int words = (length + 63) / 64;
+        const uint64_t tail = length % 64 != 0 ? (uint64_t(1) << (length % 64)) - 1 : ~uint64_t(0);
+        auto word = [&](int w) { return w == words - 1 ? mask[w] & tail : mask[w]; };
+        int mismatches = 0;
+        for (int w = 0; w < words; w++) mismatches += __builtin_popcountll(word(w));
+        SampleMutatedPositions(rng, mismatches, positions);
+        if (positions.empty() && mismatches > 0 && params.mutationRate > 0.f) positions.push_back(Bounded(rng, mismatches));
 
-        for (int c = 0; c < mutated.data.size(); c++) {
-            if (mutateCheck(rng) < params.mutationRate) {
-                mutated.data[c] = allowedSymbols[letterDist(rng)];
+        int w = 0;
+        int before = 0;
+        for (int &position : positions) {
+            while (before + __builtin_popcountll(word(w)) <= position) {
+                before += __builtin_popcountll(word(w));
+                w++;
             }
+            uint64_t bits = word(w);
+            for (int skip = position - before; skip > 0; skip--) bits &= bits - 1;
+            position = w * 64 + __builtin_ctzll(bits);
         }
-        return mutated;
     }
 
-    Individual RandomIndividual() {
-        std::uniform_int_distribution<int> lenDist(1, 30);
-        std::uniform_int_distribution<int> letterDist(0, int(allowedSymbols.size() - 1));
+    // Every position in 0..length-1 is picked independently with chance mutationRate (ascending)
+    // - instead of one random test per char, the gaps between picked positions are drawn
+    // - from the geometric distribution P(gap = g) = (1 - rate)^g * rate
+    // - so the cost is O(picked positions) instead of O(length)
+    void SampleMutatedPositions(GARng &rng, int length, std::vector<int> &positions) {
+        positions.clear();
+        if (params.mutationRate <= 0.f) return;
+        if (params.mutationRate >= 1.f) {
+            for (int c = 0; c < length; c++) positions.push_back(c);
+            return;
+        }
+        const double logKeep = std::log1p(-double(params.mutationRate));
+        for (int c = 0;; c++) {
+            const double gap = std::floor(std::log(UnitInterval(rng)) / logKeep);
+            if (gap >= length - c) break;
+            c += int(gap);
+            positions.push_back(c);
+        }
+    }
 
-        Individual i;
-        const int length = lenDist(rng);
-        for (int c = 0; c < length; c++) {
-            i.data.push_back(allowedSymbols[letterDist(rng)]);
+    // Sums the stats of all workers
+    void PrintStats(std::chrono::microseconds duration) const {
+        GenerationStats stats;
+        for (const Worker &worker : workers) {
+            stats.evaluated += worker.stats.evaluated;
+            stats.deltaEvaluated += worker.stats.deltaEvaluated;
+            stats.skipped += worker.stats.skipped;
+            stats.culled += worker.stats.culled;
         }
-        return i;
+        PrintStats(duration, stats);
+    }
+
+    void PrintStats(std::chrono::microseconds duration, const GenerationStats &stats) const {
+        std::cout << "Duration (us): " << duration.count()
+                  << " evaluated: " << stats.evaluated
+                  << " delta: " << stats.deltaEvaluated
+                  << " skipped: " << stats.skipped
+                  << " culled: " << stats.culled << std::endl;
+    }
+
+    void RandomIndividual(Worker &worker, Population &to, int slot) {
+        const int length = 1 + Bounded(worker.rng, kMaxRandomLength);
+        FillFromAlphabet(worker.rng, to.Data(slot), length, allowedSymbols.data(), allowedSymbols.size());
+        to.lengths[slot] = length;
+        to.diffs[slot] = kUnknownFitness;
+        to.masked[slot] = 0;
     }
 };
 
+// Which islands send migrants to which
+// - Ring: to the next island, Torus: to the 4 grid neighbours, Full: to every other island
+enum class Topology { Ring, Torus, Full };
 
-int main() {
-    GuessEvaluator eval{ R"(struct GAParams {
-    int generationSize = 500;
-    int eliteCount = 10;
-    int crossOverCount = 200;
-    int mutatedCount = 200;
-    float mutationRate = 0.05f;
+struct IslandParams {
+    // 0 means numOfThreads - every island gets its own thread
+    int islands = 0;
+    int migrationInterval = 50;
+    int migrants = 2;
+    Topology topology = Topology::Ring;
+    // Migrants that can wait on one link - when the receiver is behind new ones are dropped
+    int linkCapacity = 8;
+    bool verbose = true;
 };
-)"};
-    GAParams params{.individualSize=int(eval.target.size() * 2)};
+
+// Island model - every thread evolves its own GA (own populations, single-threaded pool, own seed)
+// - there are no locks: the islands only talk through one SPSC ring per link (thread_pool.h)
+// - every migrationInterval generations an island sends its `migrants` best over each out-link
+// - and writes what arrived on its in-links over its last slots (never over one of its elites)
+// - Run() stops when any island reaches fitness 0 or every island made maxGenerations
+struct IslandModel {
+    struct Migrant {
+        Fitness diff = kUnknownFitness;
+        int length = 0;
+        std::vector<char> genome;
+    };
+
+    struct Link {
+        int from;
+        int to;
+        std::unique_ptr<SpscRing<Migrant>> ring;
+    };
+
+    // Written only by the island's own thread
+    struct IslandStats {
+        long long generations = 0;
+        long long sent = 0;
+        long long dropped = 0;
+        long long received = 0;
+    };
+
+    IslandParams params;
+    std::vector<std::unique_ptr<GA>> islands;
+    std::vector<IslandStats> stats;
+    std::vector<Link> links;
+    // Indices into links for every island
+    std::vector<std::vector<int>> outLinks;
+    std::vector<std::vector<int>> inLinks;
+    std::atomic<Fitness> best{ kUnknownFitness };
+    std::atomic<bool> solved{ false };
+
+    IslandModel(GuessEvaluator &eval, const GAParams &gaParams, IslandParams params) : params(params) {
+        const int count = params.islands > 0 ? params.islands : GA::ThreadCount();
+        for (int island = 0; island < count; island++) {
+            GAParams islandParams = gaParams;
+            islandParams.seed = StreamId(gaParams.seed, island);
+            islandParams.threads = 1;
+            islandParams.verbose = false;
+            islands.push_back(std::make_unique<GA>(eval, islandParams));
+        }
+        stats.resize(count);
+        outLinks.resize(count);
+        inLinks.resize(count);
+        const int stride = islands[0]->generation.stride;
+        for (int from = 0; from < count; from++) {
+            for (int to : Neighbours(from, count, params.topology)) {
+                Link link{ from, to, std::make_unique<SpscRing<Migrant>>(params.linkCapacity) };
+                for (Migrant &migrant : link.ring->items) {
+                    migrant.genome.resize(stride);
+                }
+                outLinks[from].push_back(links.size());
+                inLinks[to].push_back(links.size());
+                links.push_back(std::move(link));
+            }
+        }
+    }
+
+    static std::vector<int> Neighbours(int island, int count, Topology topology) {
+        std::vector<int> result;
+        auto add = [&](int other) {
+            if (other != island && std::find(result.begin(), result.end(), other) == result.end()) {
+                result.push_back(other);
+            }
+        };
+        if (topology == Topology::Ring) {
+            add((island + 1) % count);
+        } else if (topology == Topology::Torus) {
+            const auto [rows, cols] = GridShape(count);
+            const int row = island / cols, col = island % cols;
+            add(row * cols + (col + 1) % cols);
+            add(row * cols + (col + cols - 1) % cols);
+            add((row + 1) % rows * cols + col);
+            add((row + rows - 1) % rows * cols + col);
+        } else {
+            for (int other = 0; other < count; other++) add(other);
+        }
+        return result;
+    }
+
+    void Run(long long maxGenerations) {
+        const int cpus = std::max(1u, std::thread::hardware_concurrency());
+        auto body = [&](int island) {
+            if (pinThreads) PinToCpu(island % cpus);
+            Evolve(island, maxGenerations);
+        };
+        std::vector<std::thread> threads;
+        for (int island = 1; island < islands.size(); island++) {
+            threads.emplace_back(body, island);
+        }
+        body(0);
+        for (auto &th : threads) th.join();
+    }
+
+    void Evolve(int island, long long maxGenerations) {
+        GA &ga = *islands[island];
+        IslandStats &islandStats = stats[island];
+        while (islandStats.generations < maxGenerations && !solved.load(std::memory_order_relaxed)) {
+            const int steps = int(std::min<long long>(params.migrationInterval, maxGenerations - islandStats.generations));
+            ga.Run(steps);
+            islandStats.generations += steps;
+
+            const Fitness fitness = ga.generation.diffs[ga.ranking[0]];
+            Fitness current = best.load(std::memory_order_relaxed);
+            while (fitness < current && !best.compare_exchange_weak(current, fitness, std::memory_order_relaxed)) {}
+            if (fitness == 0) solved.store(true, std::memory_order_relaxed);
+            if (params.verbose && island == 0 && islandStats.generations % 1000 < steps)
+                std::cout << best.load(std::memory_order_relaxed) << " generation: " << islandStats.generations
+                          << " island 0: " << ga.generation.Genome(ga.ranking[0]) << std::endl;
+
+            Emigrate(island);
+            Immigrate(island);
+        }
+    }
+
+    void Emigrate(int island) {
+        GA &ga = *islands[island];
+        IslandStats &islandStats = stats[island];
+        const int count = std::min<int>(params.migrants, ga.ranking.size());
+        for (int index : outLinks[island]) {
+            SpscRing<Migrant> &ring = *links[index].ring;
+            for (int c = 0; c < count; c++) {
+                Migrant *migrant = ring.Claim();
+                if (!migrant) {
+                    islandStats.dropped += count - c;
+                    break;
+                }
+                const int slot = ga.ranking[c];
+                migrant->diff = ga.generation.diffs[slot];
+                migrant->length = ga.generation.lengths[slot];
+                std::memcpy(migrant->genome.data(), ga.generation.Data(slot), migrant->length);
+                ring.Publish();
+                islandStats.sent++;
+            }
+        }
+    }
+
+    void Immigrate(int island) {
+        GA &ga = *islands[island];
+        IslandStats &islandStats = stats[island];
+        int slot = ga.generation.Size();
+        for (int index : inLinks[island]) {
+            SpscRing<Migrant> &ring = *links[index].ring;
+            while (Migrant *migrant = ring.Front()) {
+                slot = ga.NextImmigrantSlot(slot);
+                if (slot < 0) return;
+                ga.generation.Assign(slot, migrant->genome.data(), migrant->length, migrant->diff);
+                ring.Pop();
+                islandStats.received++;
+            }
+        }
+    }
+
+    // The best individual over all islands
+    std::string_view BestGenome() const {
+        const GA *bestIsland = islands[0].get();
+        for (const auto &ga : islands) {
+            if (ga->generation.diffs[ga->ranking[0]] < bestIsland->generation.diffs[bestIsland->ranking[0]]) {
+                bestIsland = ga.get();
+            }
+        }
+        return bestIsland->generation.Genome(bestIsland->ranking[0]);
+    }
+};
+
+struct NumaIslandParams {
+    // 0 means one island per NUMA node - more are spread over the nodes round robin
+    int islands = 0;
+    int migrationInterval = 50;
+    int migrants = 2;
+    // Data bytes of every shm ring
+    uint64_t ringBytes = 1 << 16;
+    long long maxGenerations = 100'000'000;
+    bool verbose = true;
+};
+
+// Multi-process islands for NUMA machines (Linux only)
+// - the calling process is the coordinator, it forks one island process per NUMA node
+// - an island binds its CPUs and memory to its node (BindToNode()) before it allocates its GA
+// - so its populations and its pool's threads stay on that node
+// - islands form a ring: island i pushes its best to shm ring i and reads ring i - 1
+// - migrants travel in the wire.h record format, without any lock (numa_shm.h)
+// - the coordinator watches the shared best fitness, prints progress and sets `stop` at 0
+// - returns the exit code for main()
+struct NumaIslands {
+    // Start of the shared mapping
+    struct Shared {
+        std::atomic<uint64_t> best{ kUnknownFitness };
+        std::atomic<uint32_t> stop{ 0 };
+    };
+
+    // One per island, followed by room for its best genome - written by the island only
+    struct Status {
+        alignas(64) std::atomic<long long> generations{ 0 };
+        std::atomic<uint64_t> best{ kUnknownFitness };
+        uint32_t length = 0;
+    };
+
+    GuessEvaluator &eval;
+    GAParams gaParams;
+    NumaIslandParams params;
+    std::vector<NumaNode> nodes;
+    int count = 0;
+    int stride = 0;
+    SharedMemory memory;
+
+    NumaIslands(GuessEvaluator &eval, const GAParams &gaParams, NumaIslandParams params)
+        : eval(eval), gaParams(gaParams), params(params), nodes(NumaNodes()) {
+        count = params.islands > 0 ? params.islands : int(nodes.size());
+        stride = (std::max(gaParams.individualSize, GA::kMaxRandomLength) + 63) / 64 * 64;
+    }
+
+    size_t StatusBytes() const { return sizeof(Status) + stride; }
+    size_t RingsOffset() const { return 64 + count * StatusBytes(); }
+
+    Shared &SharedState() { return *static_cast<Shared *>(memory.data); }
+    Status &IslandStatus(int island) { return *reinterpret_cast<Status *>(static_cast<char *>(memory.data) + 64 + island * StatusBytes()); }
+    ShmRing &Ring(int island) {
+        return *reinterpret_cast<ShmRing *>(static_cast<char *>(memory.data) + RingsOffset() + island * ShmRing::Footprint(params.ringBytes));
+    }
+
+    int Run() {
+#ifdef __linux__
+        const size_t bytes = RingsOffset() + count * ShmRing::Footprint(params.ringBytes);
+        if (!memory.Create("/h1-islands-" + std::to_string(getpid()), bytes)) {
+            std::cerr << "shm_open failed" << std::endl;
+            return 1;
+        }
+        new (memory.data) Shared();
+        for (int island = 0; island < count; island++) {
+            new (&IslandStatus(island)) Status();
+            new (&Ring(island)) ShmRing(params.ringBytes);
+        }
+
+        std::cout.flush();
+        std::vector<pid_t> children;
+        for (int island = 0; island < count; island++) {
+            const pid_t pid = fork();
+            if (pid == 0) {
+                // An island must not outlive its coordinator
+                prctl(PR_SET_PDEATHSIG, SIGKILL);
+                Island(island);
+                std::cout.flush();
+                _exit(0);
+            }
+            if (pid < 0) {
+                std::cerr << "fork failed" << std::endl;
+                SharedState().stop.store(1);
+                break;
+            }
+            children.push_back(pid);
+        }
+        Coordinate(children);
+        return 0;
+#else
+        std::cerr << "multi-process islands need Linux" << std::endl;
+        return 1;
+#endif
+    }
+
+    // Runs in the forked process of one island
+    void Island(int island) {
+        const NumaNode &node = nodes[island % nodes.size()];
+        const int islandsOnNode = count / int(nodes.size()) + (island % int(nodes.size()) < count % int(nodes.size()) ? 1 : 0);
+        if (!BindToNode(node) && params.verbose) {
+            std::cerr << "island " << island << ": could not bind to node " << node.id << std::endl;
+        }
+        // The node's CPU mask is inherited by the pool threads - pinning them by index would break it
+        pinThreads = false;
+
+        GAParams islandParams = gaParams;
+        islandParams.seed = StreamId(gaParams.seed, island);
+        islandParams.threads = std::max(1, int(node.cpus.size()) / std::max(1, islandsOnNode));
+        islandParams.verbose = false;
+        GA ga(eval, islandParams);
+
+        Shared &shared = SharedState();
+        Status &status = IslandStatus(island);
+        ShmRing &out = Ring(island);
+        ShmRing &in = Ring((island + count - 1) % count);
+        long long generations = 0;
+        while (generations < params.maxGenerations && !shared.stop.load(std::memory_order_relaxed)) {
+            const int steps = int(std::min<long long>(params.migrationInterval, params.maxGenerations - generations));
+            ga.Run(steps);
+            generations += steps;
+
+            const int best = ga.ranking[0];
+            const Fitness fitness = ga.generation.diffs[best];
+            status.length = ga.generation.lengths[best];
+            std::memcpy(reinterpret_cast<char *>(&status + 1), ga.generation.Data(best), status.length);
+            status.best.store(fitness, std::memory_order_relaxed);
+            status.generations.store(generations, std::memory_order_relaxed);
+            uint64_t current = shared.best.load(std::memory_order_relaxed);
+            while (fitness < current && !shared.best.compare_exchange_weak(current, fitness, std::memory_order_relaxed)) {}
+            if (fitness == 0) shared.stop.store(1, std::memory_order_relaxed);
+            if (count == 1) continue;
+
+            for (int c = 0; c < std::min<int>(params.migrants, ga.ranking.size()); c++) {
+                const int slot = ga.ranking[c];
+                if (!out.Push(ga.generation.Data(slot), ga.generation.lengths[slot], ga.generation.diffs[slot])) break;
+            }
+            uint32_t length;
+            uint64_t diff;
+            int slot = ga.NextImmigrantSlot(ga.generation.Size());
+            while (slot >= 0 && in.Pop(ga.generation.Data(slot), ga.generation.stride, length, diff)) {
+                // An empty genome or one that doesn't fit the slot is dropped - the slot takes the next migrant
+                if (length == 0 || length > uint32_t(ga.generation.stride)) continue;
+                // Pop() wrote the bytes straight into the slot - the rest is what Population::Assign() would do
+                ga.generation.lengths[slot] = int(length);
+                ga.generation.diffs[slot] = diff;
+                ga.generation.masked[slot] = 0;
+                slot = ga.NextImmigrantSlot(slot);
+            }
+        }
+    }
+
+    void Coordinate(const std::vector<pid_t> &children) {
+#ifdef __linux__
+        Shared &shared = SharedState();
+        std::vector<bool> running(children.size(), true);
+        int alive = int(children.size());
+        uint64_t printed = kUnknownFitness;
+        while (alive > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const uint64_t best = shared.best.load(std::memory_order_relaxed);
+            if (params.verbose && best != printed) {
+                printed = best;
+                std::cout << best << " generations:";
+                for (int island = 0; island < count; island++) std::cout << " " << IslandStatus(island).generations.load();
+                std::cout << std::endl;
+            }
+            if (best == 0) shared.stop.store(1, std::memory_order_relaxed);
+            for (size_t c = 0; c < children.size(); c++) {
+                if (running[c] && waitpid(children[c], nullptr, WNOHANG) == children[c]) {
+                    running[c] = false;
+                    alive--;
+                }
+            }
+        }
+        // Every island has exited, so its status is final
+        int bestIsland = 0;
+        for (int island = 1; island < count; island++) {
+            if (IslandStatus(island).best.load() < IslandStatus(bestIsland).best.load()) bestIsland = island;
+        }
+        Status &status = IslandStatus(bestIsland);
+        std::cout << status.best.load() << " island " << bestIsland << ": "
+                  << std::string_view(reinterpret_cast<const char *>(&status + 1), status.length) << std::endl;
+#endif
+    }
+};
+
+struct FederationParams {
+    // The coordinator listens here and the nodes connect here (0.0.0.0 lets a coordinator take remote nodes)
+    std::string host = "127.0.0.1";
+    uint16_t port = 5757;
+    int migrationInterval = 50;
+    // Elites a node pushes per batch, and the most migrants it gets back
+    int migrants = 2;
+    long long maxGenerations = 100'000'000;
+    // The coordinator quits once this many nodes came and left - 0 means when fitness 0 was reached
+    int nodes = 0;
+    bool verbose = true;
+};
+
+// A federation node - one GA (on numOfThreads threads) that talks to the coordinator over TCP
+// - every migrationInterval generations it sends one Push frame (progress + its elites)
+// - and blocks for the Migrants reply, so the network costs one round trip per batch of generations
+// - the coordinator hands out node ids, every node seeds its GA with its id
+// - returns the exit code for main()
+int RunFederationNode(GuessEvaluator &eval, const GAParams &gaParams, const FederationParams &params) {
+    int fd = -1;
+    // The coordinator may still be starting up
+    for (int attempt = 0; attempt < 100 && fd < 0; attempt++) {
+        fd = ConnectTo(params.host, params.port);
+        if (fd < 0) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if (fd < 0) {
+        std::cerr << "no coordinator on " << params.host << ":" << params.port << std::endl;
+        return 1;
+    }
+    FrameWriter writer;
+    std::vector<char> payload;
+    FrameType type;
+    uint32_t id = 0;
+    writer.Begin(FrameType::Hello);
+    if (!writer.Send(fd) || !RecvFrame(fd, type, payload) || type != FrameType::Welcome ||
+        !FrameReader{ payload.data(), payload.size() }.GetU32(id)) {
+        std::cerr << "handshake with the coordinator failed" << std::endl;
+        CloseSocket(fd);
+        return 1;
+    }
+
+    GAParams nodeParams = gaParams;
+    nodeParams.seed = StreamId(gaParams.seed, id);
+    nodeParams.verbose = false;
+    GA ga(eval, nodeParams);
+    long long generations = 0;
+    while (generations < params.maxGenerations) {
+        const int steps = int(std::min<long long>(params.migrationInterval, params.maxGenerations - generations));
+        ga.Run(steps);
+        generations += steps;
+
+        writer.Begin(FrameType::Push);
+        writer.PutU64(generations);
+        const int count = std::min<int>(params.migrants, ga.ranking.size());
+        writer.PutU32(count);
+        for (int c = 0; c < count; c++) {
+            const int slot = ga.ranking[c];
+            writer.AddGenome(ga.generation.Data(slot), ga.generation.lengths[slot], ga.generation.diffs[slot]);
+        }
+        if (!writer.Send(fd) || !RecvFrame(fd, type, payload) || type != FrameType::Migrants) break;
+
+        FrameReader reader{ payload.data(), payload.size() };
+        uint8_t stop = 0;
+        uint32_t migrants = 0;
+        if (!reader.GetU8(stop) || !reader.GetU32(migrants)) break;
+        int slot = ga.generation.Size();
+        for (uint32_t c = 0; c < migrants; c++) {
+            const char *genome;
+            uint32_t length;
+            uint64_t diff;
+            if (!reader.GetGenome(genome, length, diff)) break;
+            // The sender's fitness is only trusted for a genome that fits a slot as it is - an empty one
+            // - would break Mutate(), a cut one wouldn't match it any more
+            if (length == 0 || length > uint32_t(ga.generation.stride)) continue;
+            slot = ga.NextImmigrantSlot(slot);
+            if (slot < 0) break;
+            ga.generation.Assign(slot, genome, int(length), diff);
+        }
+        if (stop) break;
+    }
+    CloseSocket(fd);
+    return 0;
+}
+
+// The coordinator of a federation - a single-threaded poll() loop, it never runs a GA itself
+// - it keeps the last elites every node pushed and answers each Push with the best elites
+// - of all the other nodes, so migrants go from every node to every node
+// - it prints a progress line whenever the global best improves
+// - once the best fitness is 0 every reply tells the node to stop
+struct FederationCoordinator {
+    struct Elite {
+        Fitness diff;
+        std::string genome;
+    };
+
+    struct Peer {
+        int fd;
+        int id;
+        FrameBuffer buffer;
+        long long generations = 0;
+        std::vector<Elite> elites;
+    };
+
+    FederationParams params;
+    int listenFd;
+    std::vector<Peer> peers;
+    int nextId = 0;
+    int finished = 0;
+    Fitness best = kUnknownFitness;
+    std::string bestGenome;
+    FrameWriter writer;
+
+    // listenFd can be a socket that already listens (so forked nodes know the port), -1 opens params.port
+    FederationCoordinator(FederationParams params, int listenFd = -1) : params(params), listenFd(listenFd) {}
+
+    int Run() {
+#ifdef __linux__
+        if (listenFd < 0) listenFd = ListenOn(params.host, params.port);
+        if (listenFd < 0) {
+            std::cerr << "can't listen on " << params.host << ":" << params.port << std::endl;
+            return 1;
+        }
+        if (params.verbose) std::cout << "coordinator on " << params.host << ":" << BoundPort(listenFd) << std::endl;
+        std::vector<pollfd> fds;
+        while (true) {
+            if (peers.empty() && (params.nodes > 0 ? finished >= params.nodes : best == 0)) break;
+            fds.assign(1, pollfd{ listenFd, POLLIN, 0 });
+            for (const Peer &peer : peers) fds.push_back({ peer.fd, POLLIN, 0 });
+            if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) break;
+
+            if (fds[0].revents & POLLIN) {
+                const int fd = accept(listenFd, nullptr, nullptr);
+                if (fd >= 0) {
+                    SetNoDelay(fd);
+                    peers.push_back({ fd, nextId++ });
+                }
+            }
+            // fds[1 + c] belongs to peers[c] - a new peer was appended behind them
+            for (size_t c = 0; c + 1 < fds.size(); c++) {
+                if (fds[c + 1].revents && !Serve(peers[c])) {
+                    CloseSocket(peers[c].fd);
+                    peers[c].fd = -1;
+                    finished++;
+                }
+            }
+            peers.erase(std::remove_if(peers.begin(), peers.end(), [](const Peer &peer) { return peer.fd < 0; }), peers.end());
+        }
+        CloseSocket(listenFd);
+        if (params.verbose) std::cout << best << " best: " << bestGenome << std::endl;
+        return 0;
+#else
+        std::cerr << "the federation needs Linux" << std::endl;
+        return 1;
+#endif
+    }
+
+    // Handles every complete frame of a readable peer - false drops the connection
+    bool Serve(Peer &peer) {
+        if (!peer.buffer.Fill(peer.fd)) return false;
+        for (long long size; (size = peer.buffer.Complete()) != 0;) {
+            if (size < 0) return false;
+            const FrameType type = FrameType(uint8_t(peer.buffer.bytes[4]));
+            FrameReader reader{ peer.buffer.bytes.data() + kFrameHeader, size_t(size) - kFrameHeader };
+            bool ok = false;
+            if (type == FrameType::Hello) {
+                writer.Begin(FrameType::Welcome);
+                writer.PutU32(peer.id);
+                ok = writer.Send(peer.fd);
+            } else if (type == FrameType::Push) {
+                ok = Push(peer, reader);
+            }
+            peer.buffer.Consume(size);
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    bool Push(Peer &peer, FrameReader &reader) {
+        uint64_t generations;
+        uint32_t count;
+        if (!reader.GetU64(generations) || !reader.GetU32(count)) return false;
+        peer.generations = generations;
+        peer.elites.clear();
+        for (uint32_t c = 0; c < count; c++) {
+            const char *genome;
+            uint32_t length;
+            uint64_t diff;
+            if (!reader.GetGenome(genome, length, diff)) return false;
+            peer.elites.push_back({ diff, std::string(genome, length) });
+            if (diff < best) {
+                best = diff;
+                bestGenome = peer.elites.back().genome;
+                if (params.verbose) {
+                    std::cout << best << " node " << peer.id << " generations:";
+                    for (const Peer &other : peers) std::cout << " " << other.generations;
+                    std::cout << std::endl;
+                }
+            }
+        }
+
+        std::vector<const Elite *> migrants;
+        for (const Peer &other : peers) {
+            if (&other == &peer) continue;
+            for (const Elite &elite : other.elites) migrants.push_back(&elite);
+        }
+        const size_t kept = std::min<size_t>(params.migrants, migrants.size());
+        std::partial_sort(migrants.begin(), migrants.begin() + kept, migrants.end(),
+                          [](const Elite *a, const Elite *b) { return a->diff < b->diff; });
+        writer.Begin(FrameType::Migrants);
+        writer.PutU8(best == 0 ? 1 : 0);
+        writer.PutU32(kept);
+        for (size_t c = 0; c < kept; c++) {
+            writer.AddGenome(migrants[c]->genome.data(), migrants[c]->genome.size(), migrants[c]->diff);
+        }
+        return writer.Send(peer.fd);
+    }
+};
+
+// Benchmarks - run with ./h1.out --bench <name>
+// - they print one line per configuration and don't touch the GA defaults used by main()
+
+// The evaluator before the SIMD kernels and integer fitness
+// - kept to check the new one returns the same values while the float sum was exact
+float EvaluateFloatLoop(const std::string &target, const std::string &guess) {
+    float sum = 0;
+    for (int c = 0; c < std::min(target.size(), guess.size()); c++) {
+        const float diff = std::fabs(target[c] - guess[c]);
+        sum += diff * 256;
+    }
+    const float diffInLen = std::abs(int(guess.size()) - int(target.size()));
+    return sum + diffInLen * 256 * 256;
+}
+
+// What ./h1.out evolves
+const char *const kMainTarget = R"(struct GAParams {
+    int generationSize = 500;
+    int eliteCount = 10;
+    int crossOverCount = 200;
+    int mutatedCount = 200;
+    float mutationRate = 0.05f;
+};
+)";
+
+std::string RandomText(std::mt19937 &rng, size_t length) {
+    std::uniform_int_distribution<int> letterDist(' ', '~');
+    std::string text(length, ' ');
+    for (char &ch : text) {
+        ch = char(letterDist(rng));
+    }
+    return text;
+}
+
+// Runs fn() until minSeconds have passed and returns calls per second
+template <typename Fn>
+double CallsPerSecond(Fn &&fn, double minSeconds = 0.2) {
+    auto start = std::chrono::high_resolution_clock::now();
+    long long calls = 0;
+    double elapsed = 0;
+    for (long long batch = 1; elapsed < minSeconds; batch *= 2) {
+        for (long long c = 0; c < batch; c++) {
+            fn();
+        }
+        calls += batch;
+        elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    return calls / elapsed;
+}
+
+void BenchEvaluate() {
+    std::mt19937 rng(42);
+    std::vector<Kernel> kernels;
+    for (Kernel k : { Kernel::Scalar, Kernel::Sse2, Kernel::Avx2, Kernel::Avx512 }) {
+        if (KernelSupported(k)) kernels.push_back(k);
+    }
+    std::cout << "length    float-loop";
+    for (Kernel k : kernels) std::cout << "  " << KernelName(k);
+    std::cout << "   (evaluations/s)" << std::endl;
+
+    for (size_t length = 64; length <= (1 << 20); length *= 4) {
+        GuessEvaluator eval{ RandomText(rng, length) };
+        const std::string guess = RandomText(rng, length - length / 8);
+        volatile Fitness sink = 0;
+
+        const Fitness expected = Fitness(EvaluateFloatLoop(eval.target, guess));
+        std::cout << length << "  " << CallsPerSecond([&] { sink = Fitness(EvaluateFloatLoop(eval.target, guess)); });
+        for (Kernel k : kernels) {
+            SelectKernel(k);
+            // The float loop is only exact while the summed distance fits 24 bits
+            const bool floatExact = MakeKernelTable(Kernel::Scalar).sumAbsDiff(eval.target.data(), guess.data(), guess.size()) < (1u << 24);
+            if (floatExact && eval.Evaluate(guess) != expected) {
+                std::cout << " MISMATCH(" << KernelName(k) << ")";
+            }
+            std::cout << "  " << CallsPerSecond([&] { sink = eval.Evaluate(guess); });
+        }
+        std::cout << std::endl;
+    }
+    SelectKernel(BestKernel());
+}
+
+// Evaluate() on every genome of a population against one EvaluateBatch() over all of them
+// - genomes are 7/8 to 9/8 of the target length, like a population close to the target
+void BenchBatch() {
+    std::mt19937 rng(42);
+    const int count = 4000;
+    std::cout << "length  per-genome(evaluations/s)  batch(evaluations/s)" << std::endl;
+    for (size_t length : { 16, 160, 1024, 4096, 16384 }) {
+        GuessEvaluator eval{ RandomText(rng, length) };
+        Population population;
+        population.Resize(count, int(length + length / 8));
+        std::vector<int> slots(count);
+        std::uniform_int_distribution<int> lengthDist(int(length - length / 8), int(length + length / 8));
+        for (int c = 0; c < count; c++) {
+            const std::string genome = RandomText(rng, lengthDist(rng));
+            population.Assign(c, genome.data(), int(genome.size()), kUnknownFitness);
+            slots[c] = c;
+        }
+        std::vector<Fitness> single(count), batch(count);
+        const double singleRate = count * CallsPerSecond([&] {
+            for (int c = 0; c < count; c++) single[c] = eval.Evaluate(population.Genome(c));
+        });
+        const double batchRate = count * CallsPerSecond([&] {
+            eval.EvaluateBatch(population.Data(0), population.stride, population.lengths.data(), slots.data(), count, batch.data());
+        });
+        std::cout << length << "  " << singleRate << "  " << batchRate << (single == batch ? "" : "  MISMATCH") << std::endl;
+    }
+}
+
+// Run() with and without params.cull - generations per second, the best fitness reached
+// - and the full and delta evaluations per generation (culling must not cost the mutants their delta evaluation)
+// - the culled lower bounds change the crossover weights, so the two runs don't breed the same children
+void BenchCull() {
+    std::mt19937 rng(42);
+    std::cout << "target  generations  full(generations/s)  best  full/delta per generation"
+              << "  culled(generations/s)  best  full/delta per generation  culled share" << std::endl;
+    for (auto [length, generations] : { std::pair<size_t, int>{ 160, 2000 }, { 4096, 200 }, { 65536, 20 } }) {
+        GuessEvaluator eval{ RandomText(rng, length) };
+        std::cout << length << "  " << generations;
+        double share = 0;
+        for (bool cull : { false, true }) {
+            GA ga(eval, GAParams{ .individualSize = int(length * 2), .verbose = false, .cull = cull });
+            long long evaluated = 0, deltaEvaluated = 0, culled = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int c = 0; c < generations; c++) {
+                ga.Run(1);
+                for (const GA::Worker &worker : ga.workers) {
+                    evaluated += worker.stats.evaluated;
+                    deltaEvaluated += worker.stats.deltaEvaluated;
+                    culled += worker.stats.culled;
+                }
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            std::cout << "  " << generations / seconds << "  " << ga.generation.diffs[ga.ranking[0]] << "  "
+                      << double(evaluated) / generations << "/" << double(deltaEvaluated) / generations;
+            if (cull) share = double(culled) / std::max(1ll, evaluated);
+        }
+        std::cout << "  " << share << std::endl;
+    }
+}
+
+// Uniform against guided mutation (MutationMode) on the main() target and on 10 KB / 1 MB targets
+// - every run gets the same wall time and stops early when it finds the target
+// - generations, seconds and the best fitness reached are printed (lower is better)
+// - the 1 MB run uses a small population - two generations of 500 genomes of 2 MB don't fit everywhere
+void BenchGuided() {
+    std::mt19937 rng(42);
+    for (Kernel k : { Kernel::Sse2, Kernel::Avx2, Kernel::Avx512 }) {
+        if (!KernelSupported(k)) continue;
+        const std::string a = RandomText(rng, 1000), b = RandomText(rng, 1000);
+        std::vector<uint64_t> expected(16), mask(16);
+        const uint64_t sum = SumAbsDiffMaskScalar(a.data(), b.data(), a.size(), expected.data());
+        if (MakeKernelTable(k).sumAbsDiffMask(a.data(), b.data(), a.size(), mask.data()) != sum || mask != expected) {
+            std::cout << "MISMATCH(" << KernelName(k) << ")" << std::endl;
+        }
+    }
+    struct Workload {
+        const char *name;
+        std::string target;
+        GAParams params;
+        double seconds;
+    };
+    const Workload workloads[] = {
+        { "main()", kMainTarget, GAParams{}, 30 },
+        { "10K", RandomText(rng, 10 * 1024), GAParams{}, 30 },
+        { "1M", RandomText(rng, 1024 * 1024), GAParams{ .generationSize = 40, .eliteCount = 4, .crossOverCount = 16, .mutatedCount = 16 }, 60 },
+    };
+    std::cout << "target  mutation  generations  seconds  best" << std::endl;
+    for (const Workload &workload : workloads) {
+        GuessEvaluator eval{ workload.target };
+        for (MutationMode mode : { MutationMode::Uniform, MutationMode::Guided }) {
+            GAParams params = workload.params;
+            params.individualSize = int(eval.target.size() * 2);
+            params.mutation = mode;
+            params.verbose = false;
+            params.cull = true;
+            GA ga(eval, params);
+            long long generations = 0;
+            double seconds = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            while (seconds < workload.seconds) {
+                ga.Run(1);
+                generations++;
+                seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+                if (ga.generation.diffs[ga.ranking[0]] == 0) break;
+            }
+            std::cout << workload.name << "  " << (mode == MutationMode::Guided ? "guided" : "uniform") << "  " << generations << "  "
+                      << seconds << "  " << ga.generation.diffs[ga.ranking[0]] << std::endl;
+        }
+    }
+}
+
+// Time of one RankIndividuals() call (fitness already known) for every rank mode
+void BenchRank() {
+    std::mt19937 rng(42);
+    GuessEvaluator eval{ RandomText(rng, 64) };
+    std::cout << "generationSize  full-sort(us)  top-k(us)  radix-sort(us)" << std::endl;
+    for (int size : { 500, 5'000, 50'000, 100'000, 500'000, 1'000'000 }) {
+        GA ga(eval, GAParams{ .generationSize = 1 });
+        ga.generation.Resize(size, 64);
+        for (int c = 0; c < size; c++) {
+            const std::string genome = RandomText(rng, 64);
+            std::memcpy(ga.generation.Data(c), genome.data(), genome.size());
+            ga.generation.lengths[c] = genome.size();
+            ga.generation.diffs[c] = eval.Evaluate(genome);
+        }
+        std::cout << size;
+        for (RankMode mode : { RankMode::FullSort, RankMode::TopK, RankMode::RadixSort }) {
+            ga.params.rankMode = mode;
+            const int reps = std::max(1, 2'000'000 / size);
+            std::chrono::microseconds total(0);
+            for (int rep = 0; rep < reps; rep++) {
+                auto start = std::chrono::high_resolution_clock::now();
+                ga.RankIndividuals();
+                total += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+            }
+            std::cout << "  " << double(total.count()) / reps;
+        }
+        std::cout << std::endl;
+    }
+}
+
+// The CrossOver() body before the threshold/blend version, on std::string
+std::string CrossOverReference(std::mt19937 &rng, const std::string &a, Fitness diffA, const std::string &b, Fitness diffB) {
+    const int newLen = (a.size() + b.size()) / 2;
+    std::string result = a.size() > b.size() ? a : b;
+    result.resize(newLen);
+    std::discrete_distribution<> parentChooser({ double(2 + diffB), double(2 + diffA) });
+    const std::string *parentChoose[2] = { &a, &b };
+
+    for (int c = 0; c < std::min(a.size(), b.size()); c++) {
+        result[c] = (*parentChoose[parentChooser(rng)])[c];
+    }
+    return result;
+}
+
+// Crossovers per second (without scoring the child) - old version against every blend kernel
+void BenchCrossOver() {
+    std::mt19937 rng(42);
+    GuessEvaluator eval{ "" };
+    std::vector<Kernel> kernels;
+    for (Kernel k : { Kernel::Scalar, Kernel::Sse2, Kernel::Avx2, Kernel::Avx512 }) {
+        if (KernelSupported(k)) kernels.push_back(k);
+    }
+    std::cout << "length    before";
+    for (Kernel k : kernels) std::cout << "  " << KernelName(k);
+    std::cout << "   (crossovers/s)" << std::endl;
+
+    for (int length : { 64, 300, 4096, 65536, 1 << 20 }) {
+        const std::string a = RandomText(rng, length);
+        const std::string b = RandomText(rng, length - length / 8);
+        const Fitness diffA = 1000 * 256, diffB = 3000 * 256;
+
+        GA ga(eval, GAParams());
+        ga.generation.Resize(2, length);
+        ga.nextGeneration.Resize(1, length);
+        ga.workers[0].crossOverRandom.resize(length);
+        std::memcpy(ga.generation.Data(0), a.data(), a.size());
+        std::memcpy(ga.generation.Data(1), b.data(), b.size());
+        ga.generation.lengths = { int(a.size()), int(b.size()) };
+        ga.generation.diffs = { diffA, diffB };
+
+        std::cout << length << "  " << CallsPerSecond([&] { CrossOverReference(rng, a, diffA, b, diffB); });
+        for (Kernel k : kernels) {
+            SelectKernel(k);
+            std::vector<uint16_t> random(length);
+            std::vector<char> expected(length), blended(length);
+            for (uint32_t threshold : { 0u, 1u, 20000u, 65535u, 65536u }) {
+                FillRandom(ga.workers[0].rng, random.data(), length * sizeof(uint16_t));
+                BlendBytesScalar(expected.data(), a.data(), b.data(), random.data(), threshold, b.size());
+                ActiveKernels().blendBytes(blended.data(), a.data(), b.data(), random.data(), threshold, b.size());
+                if (expected != blended) std::cout << " MISMATCH(" << KernelName(k) << ")";
+            }
+            std::cout << "  " << CallsPerSecond([&] { ga.CrossOverGenome(ga.workers[0], ga.generation, 0, 1, ga.nextGeneration, 0); });
+        }
+        std::cout << std::endl;
+    }
+    SelectKernel(BestKernel());
+}
+
+// Mutation position sampling - one random test per char (before) against geometric gaps
+// - also prints the measured mutation rate of both, which should match mutationRate
+void BenchMutate() {
+    std::mt19937 rng(42);
+    GuessEvaluator eval{ "" };
+    GA ga(eval, GAParams());
+    std::cout << "length  per-char(samples/s)  rate  geometric(samples/s)  rate" << std::endl;
+    for (int length : { 300, 4096, 65536, 1 << 20, 4 << 20 }) {
+        std::vector<int> positions;
+        long long picked = 0, samples = 0;
+        const double perChar = CallsPerSecond([&] {
+            std::uniform_real_distribution<float> mutateCheck(0, 1);
+            positions.clear();
+            for (int c = 0; c < length; c++) {
+                if (mutateCheck(rng) < ga.params.mutationRate) positions.push_back(c);
+            }
+            picked += positions.size();
+            samples++;
+        });
+        std::cout << length << "  " << perChar << "  " << double(picked) / (double(samples) * length);
+
+        picked = 0, samples = 0;
+        const double geometric = CallsPerSecond([&] {
+            ga.SampleMutatedPositions(ga.workers[0].rng, length, positions);
+            picked += positions.size();
+            samples++;
+        });
+        std::cout << "  " << geometric << "  " << double(picked) / (double(samples) * length) << std::endl;
+    }
+}
+
+// Throughput of the engines in rng.h against std::mt19937
+template <typename Rng>
+void BenchRngEngine(const char *name, Rng rng) {
+    std::vector<char> bytes(1 << 16);
+    volatile uint32_t sink = 0;
+    const double fill = CallsPerSecond([&] { FillRandom(rng, bytes.data(), bytes.size()); }) * bytes.size() / 1e6;
+    const double bounded = CallsPerSecond([&] { for (int c = 0; c < 1024; c++) sink = Bounded(rng, 85); }) * 1024 / 1e6;
+    const double letters = CallsPerSecond([&] { FillFromAlphabet(rng, bytes.data(), bytes.size(), "abcdefghij", 10); }) * bytes.size() / 1e6;
+    std::cout << name << "  " << fill << "  " << bounded << "  " << letters << std::endl;
+}
+
+void BenchRng() {
+    std::cout << "engine  fill(MB/s)  bounded(M/s)  letters(M/s)" << std::endl;
+    BenchRngEngine("mt19937_64", std::mt19937_64(42));
+    BenchRngEngine("xoshiro256++", Xoshiro256pp(42));
+    BenchRngEngine("philox4x32-10", Philox4x32(42));
+}
+
+// The workload of the throughput benchmarks - 4000 genomes against a 4 KB target, 1600 crossovers and 1600 mutants
+// - big enough for every phase to be worth its threads, so the benchmarks measure the engines, not their overheads
+struct GAWorkload {
+    GuessEvaluator eval;
+    GAParams params;
+};
+
+GAWorkload BenchWorkload() {
+    std::mt19937 rng(42);
+    GAWorkload workload{ GuessEvaluator{ RandomText(rng, 4096) } };
+    workload.params = GAParams{ .generationSize = 4000, .eliteCount = 20, .crossOverCount = 1600, .mutatedCount = 1600,
+                                .individualSize = int(workload.eval.target.size() * 2), .verbose = false };
+    return workload;
+}
+
+// Generations per second of one engine (&GA::Run, &GA::RunTbb, ...) of ga
+// - after one untimed generation, which builds the workers, the pool and the first ranking
+double GenerationsPerSecond(GA &ga, void (GA::*engine)(int), int generations) {
+    (ga.*engine)(1);
+    auto start = std::chrono::high_resolution_clock::now();
+    (ga.*engine)(generations);
+    return generations / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Runs bench(threads) with numOfThreads set to each of the thread counts (so --pin still applies), then restores it
+template <typename Bench>
+void ForEachThreadCount(std::initializer_list<int> counts, Bench bench) {
+    const int savedThreads = numOfThreads;
+    for (int threads : counts) {
+        numOfThreads = threads;
+        bench(threads);
+    }
+    numOfThreads = savedThreads;
+}
+
+// Generations per second of Run() for 1..64 threads on BenchWorkload()
+// - speedup and efficiency are relative to the 1 thread run
+void BenchScaling() {
+    GAWorkload workload = BenchWorkload();
+    double base = 0;
+    std::cout << "threads  generations/s  speedup  efficiency  p50(us)  p99(us)" << std::endl;
+    ForEachThreadCount({ 1, 2, 4, 8, 16, 32, 64 }, [&](int threads) {
+        GA ga(workload.eval, workload.params);
+        const double rate = GenerationsPerSecond(ga, &GA::Run, 50);
+        if (threads == 1) base = rate;
+        std::cout << threads << "  " << rate << "  " << rate / base << "  " << rate / base / threads
+                  << "  " << ga.latency.Percentile(0.5) << "  " << ga.latency.Percentile(0.99) << std::endl;
+    });
+}
+
+// Time until fitness 0 - the single-population Run() (numOfThreads workers) against the island model
+// - islands use numOfThreads islands of generationSize each, in every topology
+// - generations are per island, a fitness other than 0 means maxGenerations ran out first
+void BenchIslands() {
+    GuessEvaluator eval{ "the quick brown fox jumps over the lazy dog" };
+    GAParams params{ .individualSize = int(eval.target.size() * 2), .verbose = false };
+    const long long maxGenerations = 200'000;
+    const int interval = 50;
+    std::cout << "engine  islands  seconds  generations  fitness" << std::endl;
+
+    GA ga(eval, params);
+    auto start = std::chrono::high_resolution_clock::now();
+    long long generations = 0;
+    while (generations < maxGenerations) {
+        ga.Run(interval);
+        generations += interval;
+        if (ga.generation.diffs[ga.ranking[0]] == 0) break;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "single  1  " << seconds << "  " << generations << "  " << ga.generation.diffs[ga.ranking[0]] << std::endl;
+
+    const std::pair<Topology, const char *> topologies[] = { { Topology::Ring, "ring" }, { Topology::Torus, "torus" }, { Topology::Full, "full" } };
+    for (const auto &[topology, name] : topologies) {
+        IslandModel model(eval, params, IslandParams{ .migrationInterval = interval, .topology = topology, .verbose = false });
+        start = std::chrono::high_resolution_clock::now();
+        model.Run(maxGenerations);
+        seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        long long islandGenerations = 0;
+        for (const auto &islandStats : model.stats) islandGenerations = std::max(islandGenerations, islandStats.generations);
+        std::cout << name << "  " << model.islands.size() << "  " << seconds << "  " << islandGenerations << "  " << model.best.load() << std::endl;
+    }
+}
+
+// Children evaluated per second - generational Run() against RunSteadyState() on the same budget
+// - also prints the best fitness each reached, since throughput alone says nothing about progress
+void BenchSteadyState() {
+    std::mt19937 rng(42);
+    GuessEvaluator eval{ RandomText(rng, 1024) };
+    GAParams params{ .individualSize = int(eval.target.size() * 2), .verbose = false };
+    const int generations = 200;
+    std::cout << "threads  run(evals/s)  fitness  steady-state(evals/s)  fitness" << std::endl;
+    ForEachThreadCount({ 1, 2, 4, 8, 16, 32, 64 }, [&](int threads) {
+        GA ga(eval, params);
+        // Every slot but the elites is a new child that gets scored (fully or by delta)
+        const int children = ga.generation.Size() - params.eliteCount;
+        std::cout << threads << "  " << GenerationsPerSecond(ga, &GA::Run, generations) * children << "  " << ga.generation.diffs[ga.ranking[0]];
+
+        GA steady(eval, params);
+        steady.Run(1);
+        auto start = std::chrono::high_resolution_clock::now();
+        const long long made = steady.RunSteadyState((long long)generations * children);
+        const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "  " << made / seconds << "  " << steady.generation.diffs[steady.ranking[0]] << std::endl;
+    });
+}
+
+// Generations per second and best fitness after the same number of generations - Run() against RunCellular()
+void BenchCellular() {
+    std::mt19937 rng(42);
+    GuessEvaluator eval{ RandomText(rng, 1024) };
+    GAParams params{ .individualSize = int(eval.target.size() * 2), .verbose = false };
+    std::cout << "threads  run(generations/s)  fitness  cellular(generations/s)  fitness" << std::endl;
+    ForEachThreadCount({ 1, 2, 4, 8, 16, 32, 64 }, [&](int threads) {
+        std::cout << threads;
+        for (auto engine : { &GA::Run, &GA::RunCellular }) {
+            GA ga(eval, params);
+            std::cout << "  " << GenerationsPerSecond(ga, engine, 200) << "  " << ga.generation.diffs[ga.ranking[0]];
+        }
+        std::cout << std::endl;
+    });
+}
+
+// Generations per second of Run() against RunPipelined() (half of the threads breed, half evaluate)
+void BenchPipeline() {
+    GAWorkload workload = BenchWorkload();
+    std::cout << "threads  run(generations/s)  p99(us)  pipelined(generations/s)  p99(us)" << std::endl;
+    ForEachThreadCount({ 2, 4, 8, 16, 32, 64 }, [&](int threads) {
+        std::cout << threads;
+        for (auto engine : { &GA::Run, &GA::RunPipelined }) {
+            GA ga(workload.eval, workload.params);
+            std::cout << "  " << GenerationsPerSecond(ga, engine, 50) << "  " << ga.latency.Percentile(0.99);
+        }
+        std::cout << std::endl;
+    });
+}
+
+// Generations per second of the std::thread pool (Run()) against the TBB backend (RunTbb())
+void BenchTbb() {
+    GAWorkload workload = BenchWorkload();
+    std::cout << "threads  threads(generations/s)  p99(us)  tbb(generations/s)  p99(us)" << std::endl;
+    ForEachThreadCount({ 1, 2, 4, 8, 16, 32, 64 }, [&](int threads) {
+        std::cout << threads;
+        for (auto engine : { &GA::Run, &GA::RunTbb }) {
+            GA ga(workload.eval, workload.params);
+            std::cout << "  " << GenerationsPerSecond(ga, engine, 50) << "  " << ga.latency.Percentile(0.99);
+        }
+        std::cout << std::endl;
+    });
+}
+
+// FNV-1a over every genome and fitness of a population
+uint64_t HashPopulation(const Population &population) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto mix = [&](const void *data, size_t size) {
+        for (size_t c = 0; c < size; c++) {
+            hash = (hash ^ static_cast<const unsigned char *>(data)[c]) * 0x100000001B3ull;
+        }
+    };
+    for (int c = 0; c < population.Size(); c++) {
+        mix(&population.lengths[c], sizeof(int));
+        mix(population.Data(c), population.lengths[c]);
+        mix(&population.diffs[c], sizeof(Fitness));
+    }
+    return hash;
+}
+
+// The same seeded, deterministic workload on every backend compiled in (executor.h)
+// - generations per second, speedup and efficiency (speedup / threads) against the backend on 1 thread
+// - in deterministic mode every backend must end with the same population, which is checked as well
+void BenchBackends() {
+    GAWorkload workload = BenchWorkload();
+    GAParams &params = workload.params;
+    params.deterministic = true;
+    const int maxThreads = std::max(8, GA::ThreadCount());
+    uint64_t expectedHash = 0;
+    bool same = true;
+    std::cout << "backend  threads  generations/s  speedup  efficiency" << std::endl;
+    for (Backend b : { Backend::Serial, Backend::StdExecution, Backend::ThreadPool, Backend::Tbb, Backend::OpenMP }) {
+        if (!BackendSupported(b)) {
+            std::cout << BackendName(b) << "  not compiled in" << std::endl;
+            continue;
+        }
+        params.backend = b;
+        double base = 0;
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            params.threads = threads;
+            GA ga(workload.eval, params);
+            const double rate = GenerationsPerSecond(ga, &GA::Run, 50);
+            if (threads == 1) base = rate;
+            std::cout << BackendName(b) << "  " << threads << "  " << rate << "  " << rate / base << "  " << rate / base / threads << std::endl;
+
+            const uint64_t hash = HashPopulation(ga.generation);
+            if (expectedHash == 0) expectedHash = hash;
+            same = same && hash == expectedHash;
+            // The serial backend ignores the thread count
+            if (b == Backend::Serial) break;
+        }
+    }
+    std::cout << "populations: " << (same ? "same on every backend" : "DIFFERENT") << std::endl;
+}
+
+// Run() on all threads against Run() with the autotuner, the tuning generations included
+// - a small phase (the main() workload) should fall back to serial, a big one keep its threads
+// - the tuner's decisions are printed before the rates
+void BenchAutotune() {
+    std::mt19937 rng(42);
+    struct Workload {
+        const char *name;
+        GAWorkload workload;
+        int generations;
+    };
+    Workload workloads[] = {
+        { "main()", { GuessEvaluator{ RandomText(rng, 160) }, GAParams{ .individualSize = 320, .verbose = false } }, 2000 },
+        { "4K x 4000", BenchWorkload(), 60 },
+    };
+    const int threads = std::max(4, GA::ThreadCount());
+    std::cout << "workload  threads  fixed(generations/s)  autotuned(generations/s)" << std::endl;
+    for (Workload &workload : workloads) {
+        double rates[2];
+        for (bool autotune : { false, true }) {
+            GAParams params = workload.workload.params;
+            params.threads = threads;
+            params.autotune = autotune;
+            GA ga(workload.workload.eval, params);
+            // The tuning generations are part of what is timed, so there is no warm-up
+            auto start = std::chrono::high_resolution_clock::now();
+            ga.Run(workload.generations);
+            rates[autotune] = workload.generations / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            if (autotune) {
+                for (const std::string &line : ga.tuner->decisions) std::cout << "  " << line << std::endl;
+            }
+        }
+        std::cout << workload.name << "  " << threads << "  " << rates[0] << "  " << rates[1] << std::endl;
+    }
+}
+
+// Self-checks - run with ./h1.out --check <name>, the exit code is 0 when they pass
+
+// Every operator new of the program, for --check allocations
+// - only in a build with -DH1_COUNT_ALLOCATIONS (make check-allocations), so ./h1.out keeps the plain allocator
+#ifdef H1_COUNT_ALLOCATIONS
+std::atomic<long long> allocationCount{ 0 };
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+#endif
+
+// With params.deterministic the population history must not depend on the thread count
+// - checked for Run() and RunWithP() separately (they rank and breed in a different order)
+// - RunPipelined() and RunTbb() make the same children as Run() in other places, so they must match Run()
+// - and so must Run() on every other backend
+// - Run() with params.cull (and guided mutation) is compared with itself on 1 thread, and RunTbb() with it
+bool CheckDeterminism() {
+    std::mt19937 rng(7);
+    GuessEvaluator eval{ RandomText(rng, 200) };
+    GAParams params{ .individualSize = 400, .verbose = false, .deterministic = true };
+    const int generations = 200;
+
+    enum Engine { Generational, WithP, Pipelined, Tbb };
+    const char *names[] = { "Run", "RunWithP", "RunPipelined", "RunTbb" };
+    auto history = [&](int threads, Engine engine) {
+        params.threads = threads;
+        GA ga(eval, params);
+        std::vector<uint64_t> hashes;
+        for (int c = 0; c < generations; c++) {
+            if (engine == Generational) ga.Run(1);
+            if (engine == WithP) ga.RunWithP(1);
+            if (engine == Pipelined) ga.RunPipelined(1);
+            if (engine == Tbb) ga.RunTbb(1);
+            hashes.push_back(HashPopulation(ga.generation));
+        }
+        return hashes;
+    };
+    bool ok = true;
+    const std::vector<uint64_t> expected[] = { history(1, Generational), history(1, WithP) };
+    for (Engine engine : { Generational, WithP, Pipelined, Tbb }) {
+        for (int threads : { 2, 3, 8, 64 }) {
+            const bool same = history(threads, engine) == expected[engine == WithP];
+            std::cout << names[engine] << " threads " << threads << ": " << (same ? "same" : "DIFFERENT") << std::endl;
+            ok = ok && same;
+        }
+    }
+    for (Backend b : { Backend::Serial, Backend::StdExecution, Backend::Tbb, Backend::OpenMP }) {
+        if (!BackendSupported(b)) continue;
+        params.backend = b;
+        for (int threads : { 3, 8 }) {
+            const bool same = history(threads, Generational) == expected[0];
+            std::cout << "Run on " << BackendName(b) << " threads " << threads << ": " << (same ? "same" : "DIFFERENT") << std::endl;
+            ok = ok && same;
+        }
+    }
+    params.backend = Backend::ThreadPool;
+    // The bound of a culled child only depends on the previous generation, so culling is deterministic too
+    // - and so is guided mutation, which only reads the parent
+    params.cull = true;
+    for (MutationMode mode : { MutationMode::Uniform, MutationMode::Guided }) {
+        params.mutation = mode;
+        const std::vector<uint64_t> culled = history(1, Generational);
+        for (int threads : { 3, 8 }) {
+            const bool same = history(threads, Generational) == culled;
+            std::cout << "Run culling" << (mode == MutationMode::Guided ? " guided" : "") << " threads " << threads << ": "
+                      << (same ? "same" : "DIFFERENT") << std::endl;
+            ok = ok && same;
+        }
+        // RunTbb() culls the same children
+        const bool same = history(3, Tbb) == culled;
+        std::cout << "RunTbb culling" << (mode == MutationMode::Guided ? " guided" : "") << " threads 3: " << (same ? "same" : "DIFFERENT") << std::endl;
+        ok = ok && same;
+    }
+    return ok;
+}
+
+// After warm-up a generation of Run() must not allocate (the arena, the workers and the executor are reused)
+// - checked on the serial and the thread pool backend, with the settings ./h1.out runs with
+// - TBB and std::execution allocate their tasks inside the library, so they are not checked
+bool CheckAllocations() {
+#ifndef H1_COUNT_ALLOCATIONS
+    std::cout << "allocations aren't counted in this build - run make check-allocations" << std::endl;
+    return false;
+#else
+    std::mt19937 rng(3);
+    GuessEvaluator eval{ RandomText(rng, 300) };
+    GAParams params{ .individualSize = 600, .verbose = false, .autotune = true, .cull = true };
+    params.mutation = MutationMode::Guided;
+    bool ok = true;
+    for (auto [b, threads] : { std::pair<Backend, int>{ Backend::Serial, 1 }, { Backend::ThreadPool, 1 }, { Backend::ThreadPool, 4 } }) {
+        params.backend = b;
+        params.threads = threads;
+        GA ga(eval, params);
+        // Long enough for the autotuner to decide every phase
+        ga.Run(200);
+        const long long before = allocationCount.load();
+        ga.Run(200);
+        const long long allocations = allocationCount.load() - before;
+        std::cout << BackendName(b) << " threads " << threads << ": " << allocations << " allocations in 200 generations" << std::endl;
+        ok = ok && allocations == 0;
+    }
+    return ok;
+#endif
+}
+
+// With params.cull the ranking must be exactly the one full evaluations give
+// - every exact fitness must be right, and every culled one without its kBoundedFitness flag a lower bound of a non-elite
+// - checked after every generation of Run() and RunWithP() (whose ranking is made by RankIndividuals())
+bool CheckCull() {
+    std::mt19937 rng(11);
+    GuessEvaluator eval{ RandomText(rng, 2000) };
+    GAParams params{ .individualSize = 4000, .verbose = false, .cull = true };
+    bool ok = true;
+    for (bool withP : { false, true }) {
+        GA ga(eval, params);
+        long long culled = 0;
+        for (int c = 0; c < 200 && ok; c++) {
+            withP ? ga.RunWithP(1) : ga.Run(1);
+            if (withP) ga.RankIndividuals();
+            std::vector<GA::RankKey> exact;
+            for (int slot = 0; slot < ga.generation.Size(); slot++) {
+                const Fitness fitness = eval.Evaluate(ga.generation.Genome(slot));
+                const Fitness stored = ga.generation.diffs[slot];
+                if (ExactFitness(stored) ? stored != fitness : (stored & ~kBoundedFitness) > fitness) ok = false;
+                culled += !ExactFitness(stored);
+                exact.push_back({ fitness, slot });
+            }
+            const int k = params.eliteCount;
+            std::partial_sort(exact.begin(), exact.begin() + k, exact.end());
+            for (int e = 0; e < k; e++) {
+                if (ga.ranking[e] != exact[e].index || ga.generation.diffs[ga.ranking[e]] != exact[e].diff) ok = false;
+            }
+        }
+        std::cout << (withP ? "RunWithP" : "Run") << ": " << culled << " culled, best " << ga.generation.diffs[ga.ranking[0]]
+                  << (ok ? " ok" : " FAILED") << std::endl;
+    }
+    // RunSteadyState() on a generation Run() left culled slots in - every child it counts must have been scored
+    GA ga(eval, params);
+    ga.Run(20);
+    const long long made = ga.RunSteadyState(20'000);
+    long long scored = 0;
+    for (const GA::Worker &worker : ga.workers) scored += worker.stats.evaluated + worker.stats.deltaEvaluated;
+    const bool steadyOk = scored == made;
+    std::cout << "RunSteadyState: " << made << " children, " << scored << " scored" << (steadyOk ? " ok" : " FAILED") << std::endl;
+    return ok && steadyOk;
+}
+
+// Known-answer tests of the engines in rng.h
+// - xoshiro256++: the first outputs of the reference implementation (xoshiro256plusplus.c) from state {1, 2, 3, 4}
+// - Philox4x32-10: the kat_vectors of Random123 (one block per counter and key)
+bool CheckRng() {
+    bool ok = true;
+    Xoshiro256pp xoshiro;
+    const uint64_t state[4] = { 1, 2, 3, 4 };
+    std::memcpy(xoshiro.s, state, sizeof(state));
+    const uint64_t xoshiroExpected[] = { 41943041ull, 58720359ull, 3588806011781223ull, 3591011842654386ull,
+                                         9228616714210784205ull, 9973669472204895162ull, 14011001112246962877ull,
+                                         12406186145184390807ull, 15849039046786891736ull, 10450023813501588000ull };
+    bool same = true;
+    for (uint64_t expected : xoshiroExpected) same = same && xoshiro() == expected;
+    std::cout << "xoshiro256++: " << (same ? "ok" : "FAILED") << std::endl;
+    ok = ok && same;
+
+    struct PhiloxVector {
+        uint32_t counter[4];
+        uint32_t key[2];
+        uint32_t expected[4];
+    };
+    const PhiloxVector philoxVectors[] = {
+        { { 0, 0, 0, 0 }, { 0, 0 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+        { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+        { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+    };
+    same = true;
+    for (const PhiloxVector &vector : philoxVectors) {
+        Philox4x32 philox;
+        std::memcpy(philox.counter, vector.counter, sizeof(vector.counter));
+        std::memcpy(philox.key, vector.key, sizeof(vector.key));
+        philox.Generate();
+        same = same && std::memcmp(philox.block, vector.expected, sizeof(vector.expected)) == 0;
+    }
+    std::cout << "philox4x32-10: " << (same ? "ok" : "FAILED") << std::endl;
+    return ok && same;
+}
+
+// Migrants must land on the islands of an IslandModel whatever the rank mode
+// - FullSort and RadixSort rank every slot, TopK only the elites - only the elites may be kept free of migrants
+bool CheckImmigrants() {
+    std::mt19937 rng(13);
+    GuessEvaluator eval{ RandomText(rng, 200) };
+    const char *names[] = { "full-sort", "top-k", "radix-sort" };
+    bool ok = true;
+    for (RankMode mode : { RankMode::FullSort, RankMode::TopK, RankMode::RadixSort }) {
+        GAParams params{ .individualSize = 400, .rankMode = mode, .verbose = false };
+        IslandModel model(eval, params, IslandParams{ .islands = 2, .migrationInterval = 10, .verbose = false });
+        model.Run(100);
+        long long sent = 0, received = 0;
+        for (const auto &islandStats : model.stats) {
+            sent += islandStats.sent;
+            received += islandStats.received;
+        }
+        const bool landed = received > 0;
+        std::cout << names[int(mode)] << ": " << sent << " sent, " << received << " received" << (landed ? " ok" : " FAILED") << std::endl;
+        ok = ok && landed;
+    }
+    return ok;
+}
+
+// A coordinator and 3 node processes on 127.0.0.1 must find a short target together
+bool CheckFederation() {
+#ifdef __linux__
+    GuessEvaluator eval{ "the quick brown fox" };
+    GAParams params{ .individualSize = int(eval.target.size() * 2) };
+    FederationParams federation{ .maxGenerations = 500'000, .nodes = 3, .verbose = false };
+    const int listenFd = ListenOn(federation.host, 0);
+    if (listenFd < 0) return false;
+    federation.port = BoundPort(listenFd);
+
+    std::cout.flush();
+    std::vector<pid_t> children;
+    for (int node = 0; node < federation.nodes; node++) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            CloseSocket(listenFd);
+            numOfThreads = 1;
+            _exit(RunFederationNode(eval, params, federation));
+        }
+        if (pid > 0) children.push_back(pid);
+    }
+    FederationCoordinator coordinator(federation, listenFd);
+    coordinator.Run();
+    bool ok = children.size() == size_t(federation.nodes);
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    ok = ok && coordinator.best == 0 && coordinator.bestGenome == eval.target;
+    std::cout << "federation of " << federation.nodes << " nodes: best " << coordinator.best << " \"" << coordinator.bestGenome << "\""
+              << (ok ? " ok" : " FAILED") << std::endl;
+    return ok;
+#else
+    return false;
+#endif
+}
+
+int main(int argc, char **argv) {
+    Backend backend = Backend::ThreadPool;
+    bool deterministic = false;
+    bool autotune = true;
+    bool cull = true;
+    MutationMode mutation = MutationMode::Guided;
+    bool numa = false;
+    bool coordinator = false;
+    bool node = false;
+    NumaIslandParams numaParams;
+    FederationParams federation;
+    for (int c = 1; c < argc; c++) {
+        const std::string arg = argv[c];
+        if (arg == "--coordinator") coordinator = true;
+        if (arg == "--node") node = true;
+        if (arg.rfind("--host=", 0) == 0) federation.host = arg.substr(7);
+        if (arg.rfind("--port=", 0) == 0) federation.port = uint16_t(std::stoi(arg.substr(7)));
+        if (arg.rfind("--nodes=", 0) == 0) federation.nodes = std::stoi(arg.substr(8));
+        if (arg == "--numa") numa = true;
+        if (arg.rfind("--backend=", 0) == 0 && !ParseBackend(arg.substr(10), backend)) {
+            std::cerr << "unknown backend: " << arg.substr(10) << std::endl;
+            return 1;
+        }
+        if (arg.rfind("--islands=", 0) == 0) numaParams.islands = std::stoi(arg.substr(10));
+        if (arg.rfind("--threads=", 0) == 0) numOfThreads = std::stoi(arg.substr(10));
+        if (arg == "--pin") pinThreads = true;
+        if (arg == "--deterministic") deterministic = true;
+        if (arg == "--no-autotune") autotune = false;
+        if (arg == "--no-cull") cull = false;
+        if (arg == "--mutation=guided") mutation = MutationMode::Guided;
+        if (arg == "--mutation=uniform") mutation = MutationMode::Uniform;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--check") {
+        const std::string name = argv[2];
+        if (name == "determinism") {
+            return CheckDeterminism() ? 0 : 1;
+        }
+        if (name == "federation") {
+            return CheckFederation() ? 0 : 1;
+        }
+        if (name == "cull") {
+            return CheckCull() ? 0 : 1;
+        }
+        if (name == "rng") {
+            return CheckRng() ? 0 : 1;
+        }
+        if (name == "immigrants") {
+            return CheckImmigrants() ? 0 : 1;
+        }
+        if (name == "allocations") {
+            return CheckAllocations() ? 0 : 1;
+        }
+        std::cerr << "unknown check: " << name << std::endl;
+        return 1;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--bench") {
+        const std::string name = argv[2];
+        if (name == "eval") {
+            BenchEvaluate();
+        } else if (name == "guided") {
+            BenchGuided();
+        } else if (name == "cull") {
+            BenchCull();
+        } else if (name == "batch") {
+            BenchBatch();
+        } else if (name == "rank") {
+            BenchRank();
+        } else if (name == "crossover") {
+            BenchCrossOver();
+        } else if (name == "mutate") {
+            BenchMutate();
+        } else if (name == "rng") {
+            BenchRng();
+        } else if (name == "scaling") {
+            BenchScaling();
+        } else if (name == "islands") {
+            BenchIslands();
+        } else if (name == "steady") {
+            BenchSteadyState();
+        } else if (name == "cellular") {
+            BenchCellular();
+        } else if (name == "pipeline") {
+            BenchPipeline();
+        } else if (name == "tbb") {
+            BenchTbb();
+        } else if (name == "backends") {
+            BenchBackends();
+        } else if (name == "autotune") {
+            BenchAutotune();
+        } else {
+            std::cerr << "unknown benchmark: " << name << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    GuessEvaluator eval{ kMainTarget };
+    GAParams params{.individualSize=int(eval.target.size() * 2), .deterministic=deterministic, .autotune=autotune, .cull=cull};
+    params.mutation = mutation;
+    params.backend = backend;
+    if (numa) {
+        return NumaIslands(eval, params, numaParams).Run();
+    }
+    if (coordinator) {
+        return FederationCoordinator(federation).Run();
+    }
+    if (node) {
+        return RunFederationNode(eval, params, federation);
+    }
     GA ga(eval, params);
     ga.Run(100'000'000);
     return 0;
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "wire.h"
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// TCP plumbing of the GA federation (Linux only)
+// - a frame is [u32 payload length][u8 type][payload], little endian like wire.h
+// - the payload of a frame carries whole batches of genome records, never one genome per frame
+// - everything here is blocking, FrameBuffer collects frames from a socket that poll() said is readable
+
+enum class FrameType : uint8_t {
+    // node -> coordinator: empty
+    Hello = 1,
+    // coordinator -> node: u32 node id
+    Welcome = 2,
+    // node -> coordinator: u64 generations, u32 count, count genome records (its elites)
+    Push = 3,
+    // coordinator -> node: u8 stop, u32 count, count genome records (migrants from the other nodes)
+    Migrants = 4,
+};
+
+constexpr size_t kFrameHeader = 5;
+// Anything bigger is treated as a broken peer
+constexpr uint32_t kMaxFramePayload = 64 << 20;
+
+inline void CloseSocket(int fd) {
+#ifdef __linux__
+    if (fd >= 0) close(fd);
+#endif
+}
+
+// Listens on host:port (an IPv4 address, port 0 picks a free port - see BoundPort()), -1 on failure
+inline int ListenOn(const std::string &host, uint16_t port) {
+#ifdef __linux__
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    const int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 ||
+        bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+inline uint16_t BoundPort(int fd) {
+#ifdef __linux__
+    sockaddr_in address{};
+    socklen_t size = sizeof(address);
+    if (getsockname(fd, reinterpret_cast<sockaddr *>(&address), &size) != 0) return 0;
+    return ntohs(address.sin_port);
+#else
+    return 0;
+#endif
+}
+
+// Small frames go out at once - the federation only talks every few dozen generations anyway
+inline void SetNoDelay(int fd) {
+#ifdef __linux__
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#endif
+}
+
+// Connects to host:port (an IPv4 address), -1 on failure
+inline int ConnectTo(const std::string &host, uint16_t port) {
+#ifdef __linux__
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 ||
+        connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    SetNoDelay(fd);
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+inline bool SendAll(int fd, const char *data, size_t size) {
+#ifdef __linux__
+    while (size > 0) {
+        const ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= size_t(sent);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline bool RecvAll(int fd, char *data, size_t size) {
+#ifdef __linux__
+    while (size > 0) {
+        const ssize_t received = recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        data += received;
+        size -= size_t(received);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Builds one frame in place - Begin(), then Put*() / AddGenome(), then Send()
+// - the buffer is kept between frames, so a node sends without allocating after the first batch
+struct FrameWriter {
+    std::vector<char> bytes;
+
+    void Begin(FrameType type) {
+        bytes.assign(kFrameHeader, 0);
+        bytes[4] = char(type);
+    }
+
+    void PutU8(uint8_t value) { bytes.push_back(char(value)); }
+
+    void PutU32(uint32_t value) {
+        bytes.resize(bytes.size() + 4);
+        ::PutU32(bytes.data() + bytes.size() - 4, value);
+    }
+
+    void PutU64(uint64_t value) {
+        bytes.resize(bytes.size() + 8);
+        ::PutU64(bytes.data() + bytes.size() - 8, value);
+    }
+
+    void AddGenome(const char *genome, uint32_t length, uint64_t fitness) {
+        const size_t at = bytes.size();
+        bytes.resize(at + GenomeRecordSize(length));
+        EncodeGenome(bytes.data() + at, genome, length, fitness);
+    }
+
+    bool Send(int fd) {
+        ::PutU32(bytes.data(), uint32_t(bytes.size() - kFrameHeader));
+        return SendAll(fd, bytes.data(), bytes.size());
+    }
+};
+
+// Reads a frame payload front to back - every Get*() returns false instead of reading past the end
+struct FrameReader {
+    const char *data;
+    size_t size;
+    size_t position = 0;
+
+    bool GetU8(uint8_t &value) {
+        if (size - position < 1) return false;
+        value = uint8_t(data[position++]);
+        return true;
+    }
+
+    bool GetU32(uint32_t &value) {
+        if (size - position < 4) return false;
+        value = ::GetU32(data + position);
+        position += 4;
+        return true;
+    }
+
+    bool GetU64(uint64_t &value) {
+        if (size - position < 8) return false;
+        value = ::GetU64(data + position);
+        position += 8;
+        return true;
+    }
+
+    // genome points into the frame and stays valid as long as the frame does
+    bool GetGenome(const char *&genome, uint32_t &length, uint64_t &fitness) {
+        if (size - position < kGenomeRecordHeader) return false;
+        DecodeGenomeHeader(data + position, length, fitness);
+        if (size - position - kGenomeRecordHeader < length) return false;
+        genome = data + position + kGenomeRecordHeader;
+        position += GenomeRecordSize(length);
+        return true;
+    }
+};
+
+// Blocking read of one whole frame into payload
+inline bool RecvFrame(int fd, FrameType &type, std::vector<char> &payload) {
+    char header[kFrameHeader];
+    if (!RecvAll(fd, header, kFrameHeader)) return false;
+    const uint32_t size = GetU32(header);
+    if (size > kMaxFramePayload) return false;
+    type = FrameType(uint8_t(header[4]));
+    payload.resize(size);
+    return RecvAll(fd, payload.data(), size);
+}
+
+// Collects bytes of one connection until whole frames are there (for a poll() loop)
+struct FrameBuffer {
+    std::vector<char> bytes;
+
+    // Reads what the socket has - false when the peer closed or failed
+    bool Fill(int fd) {
+#ifdef __linux__
+        char chunk[1 << 14];
+        ssize_t received;
+        do {
+            received = recv(fd, chunk, sizeof(chunk), 0);
+        } while (received < 0 && errno == EINTR);
+        if (received <= 0) return false;
+        bytes.insert(bytes.end(), chunk, chunk + received);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Size of the first frame if it is complete, 0 if not yet, -1 if it is broken
+    long long Complete() const {
+        if (bytes.size() < kFrameHeader) return 0;
+        const uint32_t size = GetU32(bytes.data());
+        if (size > kMaxFramePayload) return -1;
+        return bytes.size() >= kFrameHeader + size ? (long long)(kFrameHeader + size) : 0;
+    }
+
+    void Consume(size_t size) { bytes.erase(bytes.begin(), bytes.begin() + size); }
+};
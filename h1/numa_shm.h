@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wire.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// NUMA topology, binding and the shared memory pieces of the multi-process islands (Linux only)
+// - nodes come from /sys/devices/system/node, a machine without it is one node with every CPU
+// - memory is bound with the set_mempolicy syscall, so there is no dependency on libnuma
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus;
+};
+
+// Parses a kernel CPU list like "0-3,8-11"
+inline std::vector<int> ParseCpuList(const std::string &list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        const size_t dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+inline std::vector<NumaNode> NumaNodes() {
+    std::vector<NumaNode> nodes;
+    for (int id = 0; id < 1024; id++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+        // Node ids can have holes, so every possible id is tried
+        if (!file) continue;
+        std::string list;
+        std::getline(file, list);
+        std::vector<int> cpus = ParseCpuList(list);
+        // Memory-only nodes (no CPUs) can't run an island
+        if (!cpus.empty()) nodes.push_back({ id, std::move(cpus) });
+    }
+    if (nodes.empty()) {
+        NumaNode node{ 0, {} };
+        for (int cpu = 0; cpu < int(std::max(1u, std::thread::hardware_concurrency())); cpu++) node.cpus.push_back(cpu);
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+// Keeps the calling process (and every thread it starts later) on the node's CPUs
+// - and makes all its future allocations come from the node's memory
+// - returns false if either call was refused (e.g. a container without the capability)
+inline bool BindToNode(const NumaNode &node) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : node.cpus) CPU_SET(cpu, &set);
+    bool ok = sched_setaffinity(0, sizeof(set), &set) == 0;
+
+    constexpr int kMpolBind = 2;
+    unsigned long mask[16] = {};
+    if (node.id < int(sizeof(mask) * 8)) {
+        mask[node.id / (sizeof(unsigned long) * 8)] |= 1ul << (node.id % (sizeof(unsigned long) * 8));
+        ok = syscall(SYS_set_mempolicy, kMpolBind, mask, sizeof(mask) * 8) == 0 && ok;
+    }
+    return ok;
+#else
+    return false;
+#endif
+}
+
+// Byte ring in shared memory for one producer process and one consumer process
+// - it carries genome records (wire.h) back to back, a record may wrap around the end
+// - head and tail count bytes since the start and are only ever increased
+// - std::atomic<uint64_t> is lock-free and so also works between processes
+// - the data bytes follow the struct in the same mapping (Data())
+struct ShmRing {
+    alignas(64) std::atomic<uint64_t> head{ 0 };
+    alignas(64) std::atomic<uint64_t> tail{ 0 };
+    uint64_t capacity;
+
+    explicit ShmRing(uint64_t capacity) : capacity(capacity) {}
+
+    // Bytes a ring with `capacity` data bytes takes in the mapping (a multiple of 64)
+    static size_t Footprint(uint64_t capacity) { return (sizeof(ShmRing) + capacity + 63) / 64 * 64; }
+
+    char *Data() { return reinterpret_cast<char *>(this + 1); }
+
+    void CopyIn(uint64_t position, const char *from, size_t size) {
+        const size_t offset = position % capacity;
+        const size_t first = std::min<size_t>(size, capacity - offset);
+        std::memcpy(Data() + offset, from, first);
+        std::memcpy(Data(), from + first, size - first);
+    }
+
+    void CopyOut(uint64_t position, char *to, size_t size) {
+        const size_t offset = position % capacity;
+        const size_t first = std::min<size_t>(size, capacity - offset);
+        std::memcpy(to, Data() + offset, first);
+        std::memcpy(to + first, Data(), size - first);
+    }
+
+    // Returns false (and drops the genome) when the consumer is too far behind
+    bool Push(const char *genome, uint32_t length, uint64_t fitness) {
+        const uint64_t t = tail.load(std::memory_order_relaxed);
+        const size_t size = GenomeRecordSize(length);
+        if (capacity - (t - head.load(std::memory_order_acquire)) < size) return false;
+        char header[kGenomeRecordHeader];
+        PutU32(header, length);
+        PutU64(header + 4, fitness);
+        CopyIn(t, header, kGenomeRecordHeader);
+        CopyIn(t + kGenomeRecordHeader, genome, length);
+        tail.store(t + size, std::memory_order_release);
+        return true;
+    }
+
+    // Removes the oldest genome and copies it to out, false when empty
+    // - length is the genome's own - one longer than maxLength is removed without copying anything
+    bool Pop(char *out, int maxLength, uint32_t &length, uint64_t &fitness) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        char header[kGenomeRecordHeader];
+        CopyOut(h, header, kGenomeRecordHeader);
+        DecodeGenomeHeader(header, length, fitness);
+        if (length <= uint32_t(maxLength)) CopyOut(h + kGenomeRecordHeader, out, length);
+        head.store(h + GenomeRecordSize(length), std::memory_order_release);
+        return true;
+    }
+};
+
+// A POSIX shared memory object mapped into this process
+// - the name is unlinked as soon as it is mapped: forked children inherit the mapping
+// - and nothing is left behind in /dev/shm if a process dies
+struct SharedMemory {
+    void *data = nullptr;
+    size_t size = 0;
+
+    SharedMemory() = default;
+    SharedMemory(const SharedMemory &) = delete;
+    SharedMemory &operator=(const SharedMemory &) = delete;
+
+    // Returns false if the object could not be created or mapped
+    bool Create(const std::string &name, size_t bytes) {
+#ifdef __linux__
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return false;
+        shm_unlink(name.c_str());
+        if (ftruncate(fd, off_t(bytes)) != 0) {
+            close(fd);
+            return false;
+        }
+        void *mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) return false;
+        data = mapped;
+        size = bytes;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    ~SharedMemory() {
+#ifdef __linux__
+        if (data) munmap(data, size);
+#endif
+    }
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// Random number engines and bulk helpers used by GA
+// - both engines are UniformRandomBitGenerators with 64-bit output, so std distributions work too
+// - Engine::Stream(seed, stream) gives an independent, reproducible stream for any stream id
+// - (a worker, a child slot, ...) without having to advance a shared engine
+// - Jump() moves an engine far enough ahead that it won't overlap with where it was
+
+inline uint64_t SplitMix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Mixes several ids (seed, generation, slot, ...) into one well spread stream id
+inline uint64_t StreamId(uint64_t a, uint64_t b, uint64_t c = 0) {
+    uint64_t state = a;
+    state = SplitMix64(state) ^ b;
+    state = SplitMix64(state) ^ c;
+    return SplitMix64(state);
+}
+
+// xoshiro256++ by Blackman and Vigna - 4 words of state, a few ns per 64 bits
+struct Xoshiro256pp {
+    using result_type = uint64_t;
+    uint64_t s[4];
+
+    explicit Xoshiro256pp(uint64_t seed = 42) {
+        for (uint64_t &word : s) {
+            word = SplitMix64(seed);
+        }
+    }
+
+    static Xoshiro256pp Stream(uint64_t seed, uint64_t stream) {
+        return Xoshiro256pp(StreamId(seed, stream));
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    result_type operator()() {
+        const uint64_t result = Rotl(s[0] + s[3], 23) + s[0];
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 45);
+        return result;
+    }
+
+    // Equivalent to 2^128 calls of operator()
+    void Jump() {
+        static const uint64_t jump[] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+        uint64_t t[4] = {};
+        for (uint64_t word : jump) {
+            for (int b = 0; b < 64; b++) {
+                if (word & (uint64_t(1) << b)) {
+                    for (int c = 0; c < 4; c++) t[c] ^= s[c];
+                }
+                (*this)();
+            }
+        }
+        std::memcpy(s, t, sizeof(s));
+    }
+};
+
+// Philox4x32-10 by Salmon et al. - counter based, output block n is a pure function of (key, n)
+// - so streams are just different counter prefixes, and no state has to be carried around
+struct Philox4x32 {
+    using result_type = uint64_t;
+    uint32_t key[2];
+    // counter[0..1] counts blocks, counter[2..3] holds the stream id
+    uint32_t counter[4] = {};
+    uint32_t block[4] = {};
+    int used = 4;
+
+    explicit Philox4x32(uint64_t seed = 42, uint64_t stream = 0) {
+        key[0] = uint32_t(seed);
+        key[1] = uint32_t(seed >> 32);
+        counter[2] = uint32_t(stream);
+        counter[3] = uint32_t(stream >> 32);
+    }
+
+    static Philox4x32 Stream(uint64_t seed, uint64_t stream) {
+        return Philox4x32(seed, stream);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    void Generate() {
+        uint32_t x[4] = { counter[0], counter[1], counter[2], counter[3] };
+        uint32_t k[2] = { key[0], key[1] };
+        for (int round = 0; round < 10; round++) {
+            const uint64_t p0 = uint64_t(0xD2511F53u) * x[0];
+            const uint64_t p1 = uint64_t(0xCD9E8D57u) * x[2];
+            const uint32_t y[4] = { uint32_t(p1 >> 32) ^ x[1] ^ k[0], uint32_t(p1), uint32_t(p0 >> 32) ^ x[3] ^ k[1], uint32_t(p0) };
+            std::memcpy(x, y, sizeof(x));
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        std::memcpy(block, x, sizeof(block));
+        if (++counter[0] == 0) counter[1]++;
+        used = 0;
+    }
+
+    result_type operator()() {
+        if (used == 4) Generate();
+        const uint64_t result = (uint64_t(block[used]) << 32) | block[used + 1];
+        used += 2;
+        return result;
+    }
+
+    // Skips 2^32 blocks (2^33 calls of operator())
+    void Jump() {
+        counter[1]++;
+        used = 4;
+    }
+};
+
+// A uniform value in 0..range-1 (Lemire's nearly divisionless method)
+// - uses the high 32 bits of one engine call, a division only happens on the rare retry path
+template <typename Rng>
+uint32_t Bounded(Rng &rng, uint32_t range) {
+    uint64_t m = (rng() >> 32) * range;
+    uint32_t low = uint32_t(m);
+    if (low < range) {
+        const uint32_t threshold = uint32_t(-range) % range;
+        while (low < threshold) {
+            m = (rng() >> 32) * range;
+            low = uint32_t(m);
+        }
+    }
+    return uint32_t(m >> 32);
+}
+
+// A uniform double in (0, 1] - never 0, so it is safe to take its log
+template <typename Rng>
+double UnitInterval(Rng &rng) {
+    return double((rng() >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+// Fills `bytes` random bytes, 8 per engine call
+template <typename Rng>
+void FillRandom(Rng &rng, void *out, size_t bytes) {
+    char *dst = static_cast<char *>(out);
+    size_t c = 0;
+    for (; c + 8 <= bytes; c += 8) {
+        const uint64_t bits = rng();
+        std::memcpy(dst + c, &bits, 8);
+    }
+    if (c < bytes) {
+        const uint64_t bits = rng();
+        std::memcpy(dst + c, &bits, bytes - c);
+    }
+}
+
+// Fills out[0..count-1] with uniform picks from alphabet[0..alphabetSize-1]
+// - both 32-bit halves of every engine call go through Lemire's method
+template <typename Rng>
+void FillFromAlphabet(Rng &rng, char *out, size_t count, const char *alphabet, uint32_t alphabetSize) {
+    const uint32_t threshold = uint32_t(-alphabetSize) % alphabetSize;
+    size_t c = 0;
+    while (c < count) {
+        const uint64_t bits = rng();
+        const uint64_t halves[2] = { bits >> 32, bits & 0xFFFFFFFFu };
+        for (uint64_t half : halves) {
+            const uint64_t m = half * alphabetSize;
+            if (uint32_t(m) < threshold) continue;
+            out[c++] = alphabet[m >> 32];
+            if (c == count) break;
+        }
+    }
+}
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define H1_X86 1
+#endif
+
+// Byte kernels used by GuessEvaluator and GA::CrossOver()
+// - every kernel has a scalar version and x86 versions (SSE2, AVX2, AVX-512BW)
+// - the best version is picked once at startup with __builtin_cpu_supports()
+// - SelectKernel() can force a specific one (used by the benchmarks)
+
+// The old evaluator computed target[c] - guess[c] on (signed) char
+// - psadbw works on unsigned bytes, so we flip the sign bit of both inputs first
+// - that maps -128..127 onto 0..255 and keeps every |a - b| the same
+constexpr uint8_t kSignFlip = std::is_signed<char>::value ? 0x80 : 0x00;
+
+enum class Kernel { Scalar, Sse2, Avx2, Avx512 };
+
+inline const char *KernelName(Kernel k) {
+    switch (k) {
+        case Kernel::Scalar: return "scalar";
+        case Kernel::Sse2: return "sse2";
+        case Kernel::Avx2: return "avx2";
+        case Kernel::Avx512: return "avx512";
+    }
+    return "?";
+}
+
+// Sum of |a[c] - b[c]| over n chars - exact, no float conversions
+inline uint64_t SumAbsDiffScalar(const char *a, const char *b, size_t n) {
+    uint64_t sum = 0;
+    for (size_t c = 0; c < n; c++) {
+        sum += std::abs(int(a[c]) - int(b[c]));
+    }
+    return sum;
+}
+
+#ifdef H1_X86
+__attribute__((target("sse2")))
+inline uint64_t SumAbsDiffSse2(const char *a, const char *b, size_t n) {
+    const __m128i flip = _mm_set1_epi8(char(kSignFlip));
+    __m128i acc = _mm_setzero_si128();
+    size_t c = 0;
+    for (; c + 16 <= n; c += 16) {
+        const __m128i va = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + c)), flip);
+        const __m128i vb = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(b + c)), flip);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + SumAbsDiffScalar(a + c, b + c, n - c);
+}
+
+__attribute__((target("avx2")))
+inline uint64_t SumAbsDiffAvx2(const char *a, const char *b, size_t n) {
+    const __m256i flip = _mm256_set1_epi8(char(kSignFlip));
+    __m256i acc = _mm256_setzero_si256();
+    size_t c = 0;
+    for (; c + 32 <= n; c += 32) {
+        const __m256i va = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + c)), flip);
+        const __m256i vb = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(b + c)), flip);
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumAbsDiffSse2(a + c, b + c, n - c);
+}
+
+__attribute__((target("avx512bw")))
+inline uint64_t SumAbsDiffAvx512(const char *a, const char *b, size_t n) {
+    const __m512i flip = _mm512_set1_epi8(char(kSignFlip));
+    __m512i acc = _mm512_setzero_si512();
+    size_t c = 0;
+    for (; c + 64 <= n; c += 64) {
+        const __m512i va = _mm512_xor_si512(_mm512_loadu_si512(a + c), flip);
+        const __m512i vb = _mm512_xor_si512(_mm512_loadu_si512(b + c), flip);
+        acc = _mm512_add_epi64(acc, _mm512_sad_epu8(va, vb));
+    }
+    return _mm512_reduce_add_epi64(acc) + SumAbsDiffAvx2(a + c, b + c, n - c);
+}
+#endif
+
+// SumAbsDiff*() that also writes where a and b differ - bit c of mask is set when a[c] != b[c]
+// - mask gets (n + 63) / 64 words, the bits past n are 0
+// - the x86 versions compare the same vectors psadbw reads (cmpeq + movemask, or a k-mask on AVX-512)
+// - and build one 64-bit word per 64 bytes
+inline uint64_t SumAbsDiffMaskScalar(const char *a, const char *b, size_t n, uint64_t *mask) {
+    std::fill(mask, mask + (n + 63) / 64, 0);
+    uint64_t sum = 0;
+    for (size_t c = 0; c < n; c++) {
+        sum += std::abs(int(a[c]) - int(b[c]));
+        mask[c / 64] |= uint64_t(a[c] != b[c]) << (c % 64);
+    }
+    return sum;
+}
+
+#ifdef H1_X86
+__attribute__((target("sse2")))
+inline uint64_t SumAbsDiffMaskSse2(const char *a, const char *b, size_t n, uint64_t *mask) {
+    const __m128i flip = _mm_set1_epi8(char(kSignFlip));
+    __m128i acc = _mm_setzero_si128();
+    size_t c = 0;
+    for (; c + 64 <= n; c += 64) {
+        uint64_t word = 0;
+        for (int part = 0; part < 4; part++) {
+            const __m128i va = _mm_loadu_si128((const __m128i *)(a + c + 16 * part));
+            const __m128i vb = _mm_loadu_si128((const __m128i *)(b + c + 16 * part));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_xor_si128(va, flip), _mm_xor_si128(vb, flip)));
+            const uint32_t equal = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+            word |= uint64_t(~equal & 0xFFFFu) << (16 * part);
+        }
+        mask[c / 64] = word;
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + SumAbsDiffMaskScalar(a + c, b + c, n - c, mask + c / 64);
+}
+
+__attribute__((target("avx2")))
+inline uint64_t SumAbsDiffMaskAvx2(const char *a, const char *b, size_t n, uint64_t *mask) {
+    const __m256i flip = _mm256_set1_epi8(char(kSignFlip));
+    __m256i acc = _mm256_setzero_si256();
+    size_t c = 0;
+    for (; c + 64 <= n; c += 64) {
+        uint64_t word = 0;
+        for (int part = 0; part < 2; part++) {
+            const __m256i va = _mm256_loadu_si256((const __m256i *)(a + c + 32 * part));
+            const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + c + 32 * part));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_xor_si256(va, flip), _mm256_xor_si256(vb, flip)));
+            const uint32_t equal = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+            word |= uint64_t(~equal) << (32 * part);
+        }
+        mask[c / 64] = word;
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumAbsDiffMaskScalar(a + c, b + c, n - c, mask + c / 64);
+}
+
+__attribute__((target("avx512bw")))
+inline uint64_t SumAbsDiffMaskAvx512(const char *a, const char *b, size_t n, uint64_t *mask) {
+    const __m512i flip = _mm512_set1_epi8(char(kSignFlip));
+    __m512i acc = _mm512_setzero_si512();
+    size_t c = 0;
+    for (; c + 64 <= n; c += 64) {
+        const __m512i va = _mm512_loadu_si512(a + c);
+        const __m512i vb = _mm512_loadu_si512(b + c);
+        acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_xor_si512(va, flip), _mm512_xor_si512(vb, flip)));
+        mask[c / 64] = _mm512_cmpneq_epi8_mask(va, vb);
+    }
+    return _mm512_reduce_add_epi64(acc) + SumAbsDiffMaskScalar(a + c, b + c, n - c, mask + c / 64);
+}
+#endif
+
+// No limit for SumAbsDiffUntil() / SumAbsDiffBatch()
+constexpr uint64_t kNoLimit = ~uint64_t(0);
+// SumAbsDiffUntil() checks the limit every this many bytes
+constexpr size_t kLimitBlock = 512;
+
+// The sum of sumAbsDiff(a, b, n), but it stops at the first block where the sum reached limit
+// - so the result is exact if it is below limit, otherwise it is some value >= limit
+// - a limit of 0 returns 0 without reading anything
+inline uint64_t SumAbsDiffUntil(uint64_t (*sumAbsDiff)(const char *, const char *, size_t), const char *a, const char *b, size_t n,
+                                uint64_t limit) {
+    if (limit == kNoLimit) return sumAbsDiff(a, b, n);
+    uint64_t sum = 0;
+    for (size_t c = 0; c < n && sum < limit; c += kLimitBlock) {
+        sum += sumAbsDiff(a + c, b + c, std::min(kLimitBlock, n - c));
+    }
+    return sum;
+}
+
+// sums[i] = sum of |target[c] - genome[c]| over the common length, for genome i at arena + slots[i] * stride
+// - lengths is indexed by slot, like the arena
+// - sums[i] is also an input: the limit of genome i for SumAbsDiffUntil() (kNoLimit for an exact sum)
+// - one call scores a whole batch: the kernel is picked once, the target stays in L1 between genomes
+// - and the first lines of the genome after next are prefetched while this one is scanned
+template <uint64_t (*SumAbsDiff)(const char *, const char *, size_t)>
+inline void SumAbsDiffBatch(const char *target, size_t targetLength, const char *arena, size_t stride,
+                            const int *lengths, const int *slots, size_t count, uint64_t *sums) {
+    for (size_t i = 0; i < count; i++) {
+        if (i + 2 < count) {
+            const char *ahead = arena + size_t(slots[i + 2]) * stride;
+            __builtin_prefetch(ahead);
+            __builtin_prefetch(ahead + 64);
+        }
+        const size_t length = std::min<size_t>(size_t(lengths[slots[i]]), targetLength);
+        sums[i] = SumAbsDiffUntil(SumAbsDiff, target, arena + size_t(slots[i]) * stride, length, sums[i]);
+    }
+}
+
+// dst[c] = random[c] < threshold ? a[c] : b[c]
+// - threshold is in 0..65536, so 0 always takes b and 65536 always takes a
+inline void BlendBytesScalar(char *dst, const char *a, const char *b, const uint16_t *random, uint32_t threshold, size_t n) {
+    for (size_t c = 0; c < n; c++) {
+        dst[c] = random[c] < threshold ? a[c] : b[c];
+    }
+}
+
+#ifdef H1_X86
+// SSE2 only has a signed 16-bit compare - flipping the top bit of both sides makes it unsigned
+__attribute__((target("sse2")))
+inline void BlendBytesSse2(char *dst, const char *a, const char *b, const uint16_t *random, uint32_t threshold, size_t n) {
+    if (threshold == 0 || threshold >= 65536) {
+        std::memcpy(dst, threshold ? a : b, n);
+        return;
+    }
+    const __m128i flip = _mm_set1_epi16(short(0x8000));
+    const __m128i limit = _mm_xor_si128(_mm_set1_epi16(short(threshold)), flip);
+    size_t c = 0;
+    for (; c + 16 <= n; c += 16) {
+        const __m128i r0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(random + c)), flip);
+        const __m128i r1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(random + c + 8)), flip);
+        const __m128i mask = _mm_packs_epi16(_mm_cmplt_epi16(r0, limit), _mm_cmplt_epi16(r1, limit));
+        const __m128i va = _mm_loadu_si128((const __m128i *)(a + c));
+        const __m128i vb = _mm_loadu_si128((const __m128i *)(b + c));
+        _mm_storeu_si128((__m128i *)(dst + c), _mm_or_si128(_mm_and_si128(mask, va), _mm_andnot_si128(mask, vb)));
+    }
+    BlendBytesScalar(dst + c, a + c, b + c, random + c, threshold, n - c);
+}
+
+__attribute__((target("avx2")))
+inline void BlendBytesAvx2(char *dst, const char *a, const char *b, const uint16_t *random, uint32_t threshold, size_t n) {
+    if (threshold == 0 || threshold >= 65536) {
+        std::memcpy(dst, threshold ? a : b, n);
+        return;
+    }
+    const __m256i flip = _mm256_set1_epi16(short(0x8000));
+    const __m256i limit = _mm256_xor_si256(_mm256_set1_epi16(short(threshold)), flip);
+    size_t c = 0;
+    for (; c + 32 <= n; c += 32) {
+        const __m256i r0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(random + c)), flip);
+        const __m256i r1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(random + c + 16)), flip);
+        // packs works per 128-bit lane, the permute puts the bytes back in order
+        const __m256i packed = _mm256_packs_epi16(_mm256_cmpgt_epi16(limit, r0), _mm256_cmpgt_epi16(limit, r1));
+        const __m256i mask = _mm256_permute4x64_epi64(packed, 0xD8);
+        const __m256i va = _mm256_loadu_si256((const __m256i *)(a + c));
+        const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + c));
+        _mm256_storeu_si256((__m256i *)(dst + c), _mm256_blendv_epi8(vb, va, mask));
+    }
+    BlendBytesSse2(dst + c, a + c, b + c, random + c, threshold, n - c);
+}
+
+__attribute__((target("avx512bw,avx512vl")))
+inline void BlendBytesAvx512(char *dst, const char *a, const char *b, const uint16_t *random, uint32_t threshold, size_t n) {
+    if (threshold == 0 || threshold >= 65536) {
+        std::memcpy(dst, threshold ? a : b, n);
+        return;
+    }
+    const __m512i limit = _mm512_set1_epi16(short(threshold));
+    size_t c = 0;
+    for (; c + 32 <= n; c += 32) {
+        const __mmask32 takeA = _mm512_cmplt_epu16_mask(_mm512_loadu_si512(random + c), limit);
+        const __m256i va = _mm256_loadu_si256((const __m256i *)(a + c));
+        const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + c));
+        _mm256_storeu_si256((__m256i *)(dst + c), _mm256_mask_blend_epi8(takeA, vb, va));
+    }
+    BlendBytesSse2(dst + c, a + c, b + c, random + c, threshold, n - c);
+}
+#endif
+
+inline bool KernelSupported(Kernel k) {
+#ifdef H1_X86
+    __builtin_cpu_init();
+    switch (k) {
+        case Kernel::Scalar: return true;
+        case Kernel::Sse2: return __builtin_cpu_supports("sse2");
+        case Kernel::Avx2: return __builtin_cpu_supports("avx2");
+        case Kernel::Avx512: return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+    }
+    return false;
+#else
+    return k == Kernel::Scalar;
+#endif
+}
+
+inline Kernel BestKernel() {
+    for (Kernel k : { Kernel::Avx512, Kernel::Avx2, Kernel::Sse2 }) {
+        if (KernelSupported(k)) return k;
+    }
+    return Kernel::Scalar;
+}
+
+struct KernelTable {
+    Kernel kernel = Kernel::Scalar;
+    uint64_t (*sumAbsDiff)(const char *, const char *, size_t) = SumAbsDiffScalar;
+    void (*sumAbsDiffBatch)(const char *, size_t, const char *, size_t, const int *, const int *, size_t, uint64_t *) =
+        SumAbsDiffBatch<SumAbsDiffScalar>;
+    uint64_t (*sumAbsDiffMask)(const char *, const char *, size_t, uint64_t *) = SumAbsDiffMaskScalar;
+    void (*blendBytes)(char *, const char *, const char *, const uint16_t *, uint32_t, size_t) = BlendBytesScalar;
+};
+
+inline KernelTable MakeKernelTable(Kernel k) {
+    KernelTable table;
+    table.kernel = k;
+#ifdef H1_X86
+    switch (k) {
+        case Kernel::Scalar: break;
+        case Kernel::Sse2:
+            table.sumAbsDiff = SumAbsDiffSse2;
+            table.sumAbsDiffBatch = SumAbsDiffBatch<SumAbsDiffSse2>;
+            table.sumAbsDiffMask = SumAbsDiffMaskSse2;
+            table.blendBytes = BlendBytesSse2;
+            break;
+        case Kernel::Avx2:
+            table.sumAbsDiff = SumAbsDiffAvx2;
+            table.sumAbsDiffBatch = SumAbsDiffBatch<SumAbsDiffAvx2>;
+            table.sumAbsDiffMask = SumAbsDiffMaskAvx2;
+            table.blendBytes = BlendBytesAvx2;
+            break;
+        case Kernel::Avx512:
+            table.sumAbsDiff = SumAbsDiffAvx512;
+            table.sumAbsDiffBatch = SumAbsDiffBatch<SumAbsDiffAvx512>;
+            table.sumAbsDiffMask = SumAbsDiffMaskAvx512;
+            table.blendBytes = BlendBytesAvx512;
+            break;
+    }
+#endif
+    return table;
+}
+
+inline KernelTable &ActiveKernels() {
+    static KernelTable table = MakeKernelTable(BestKernel());
+    return table;
+}
+
+// Returns false (and keeps the current kernels) if the CPU can't run k
+inline bool SelectKernel(Kernel k) {
+    if (!KernelSupported(k)) return false;
+    ActiveKernels() = MakeKernelTable(k);
+    return true;
+}
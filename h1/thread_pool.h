@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Waiting in the pool and the barrier spins first and parks (sleeps on a condition variable) after
+// - a generation of a few hundred individuals takes microseconds, much less than a wake-up
+// - so short waits stay on the CPU, while long ones (or too many threads for the cores) sleep
+constexpr int kSpinsBeforePark = 4000;
+
+// Non-owning reference to a callable - an object pointer and a trampoline, nothing is copied or allocated
+// - std::function heap-allocates any lambda that captures more than two pointers, and the loops of a
+// - generation are such lambdas, so every parallel loop takes its body as a FunctionRef instead
+// - the callable must outlive the reference (a lambda passed straight into the call is fine)
+template <typename Signature>
+struct FunctionRef;
+
+template <typename R, typename... Args>
+struct FunctionRef<R(Args...)> {
+    void *object;
+    R (*call)(void *, Args...);
+
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, FunctionRef>::value>>
+    FunctionRef(F &&fn)
+        : object(const_cast<void *>(static_cast<const void *>(std::addressof(fn)))),
+          call([](void *o, Args... args) -> R { return (*static_cast<std::remove_reference_t<F> *>(o))(std::forward<Args>(args)...); }) {}
+
+    R operator()(Args... args) const { return call(object, std::forward<Args>(args)...); }
+};
+
+// Reusable barrier for a fixed number of threads (sense reversing, spin-then-park)
+struct Barrier {
+    const int count;
+    std::atomic<int> waiting{ 0 };
+    std::atomic<unsigned> phase{ 0 };
+    std::atomic<int> parked{ 0 };
+    std::mutex mtx;
+    std::condition_variable wake;
+
+    explicit Barrier(int count) : count(count) {}
+
+    void Wait() {
+        const unsigned current = phase.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            waiting.store(0, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                phase.store(current + 1, std::memory_order_release);
+            }
+            if (parked.load(std::memory_order_acquire) > 0) wake.notify_all();
+            return;
+        }
+        for (int spin = 0; spin < kSpinsBeforePark; spin++) {
+            if (phase.load(std::memory_order_acquire) != current) return;
+            if (spin > kSpinsBeforePark / 2) std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        parked.fetch_add(1, std::memory_order_acq_rel);
+        wake.wait(lock, [&] { return phase.load(std::memory_order_acquire) != current; });
+        parked.fetch_sub(1, std::memory_order_acq_rel);
+    }
+};
+
+// Pins the calling thread to one CPU (Linux only, a no-op elsewhere)
+inline void PinToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+// A fixed set of threads that live as long as the pool
+// - Run(task) calls task(worker) once on every worker and returns when all are done
+// - the calling thread is worker 0, so a pool of size 1 has no extra threads at all
+// - idle workers spin on the round counter for a while and then park
+// - with pin = true worker w is pinned to CPU w % hardware_concurrency()
+struct WorkerPool {
+    std::vector<std::thread> threads;
+    std::atomic<unsigned long long> round{ 0 };
+    std::atomic<int> pending{ 0 };
+    std::atomic<int> parked{ 0 };
+    std::atomic<bool> stopping{ false };
+    const FunctionRef<void(int)> *task = nullptr;
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const bool pinned;
+
+    explicit WorkerPool(int size, bool pin = false) : pinned(pin) {
+        const int cpus = std::max(1u, std::thread::hardware_concurrency());
+        if (pin) PinToCpu(0);
+        for (int w = 1; w < size; w++) {
+            threads.emplace_back([this, w, pin, cpus] {
+                if (pin) PinToCpu(w % cpus);
+                Loop(w);
+            });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping.store(true, std::memory_order_release);
+        }
+        wake.notify_all();
+        for (auto &th : threads) th.join();
+    }
+
+    int Size() const { return int(threads.size()) + 1; }
+
+    void Run(FunctionRef<void(int)> fn) {
+        task = &fn;
+        pending.store(int(threads.size()), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            round.fetch_add(1, std::memory_order_release);
+        }
+        if (parked.load(std::memory_order_acquire) > 0) wake.notify_all();
+        fn(0);
+
+        for (int spin = 0; spin < kSpinsBeforePark; spin++) {
+            if (pending.load(std::memory_order_acquire) == 0) return;
+            if (spin > kSpinsBeforePark / 2) std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        done.wait(lock, [this] { return pending.load(std::memory_order_acquire) == 0; });
+    }
+
+    void Loop(int worker) {
+        unsigned long long seen = 0;
+        while (true) {
+            bool ready = false;
+            for (int spin = 0; spin < kSpinsBeforePark && !ready; spin++) {
+                ready = round.load(std::memory_order_acquire) != seen || stopping.load(std::memory_order_acquire);
+                if (spin > kSpinsBeforePark / 2) std::this_thread::yield();
+            }
+            if (!ready) {
+                std::unique_lock<std::mutex> lock(mtx);
+                parked.fetch_add(1, std::memory_order_acq_rel);
+                wake.wait(lock, [&] { return round.load(std::memory_order_acquire) != seen || stopping.load(std::memory_order_acquire); });
+                parked.fetch_sub(1, std::memory_order_acq_rel);
+            }
+            if (stopping.load(std::memory_order_acquire)) return;
+            seen = round.load(std::memory_order_acquire);
+            (*task)(worker);
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mtx);
+                done.notify_one();
+            }
+        }
+    }
+};
+
+// [first, last) of `count` items for worker `worker` of `workers` - static, contiguous chunks
+inline std::pair<int, int> ChunkOf(int count, int worker, int workers) {
+    return { int((long long)count * worker / workers), int((long long)count * (worker + 1) / workers) };
+}
+
+// Collects per-generation wall times and reports percentiles
+struct LatencyStats {
+    std::vector<long long> samples;
+
+    void Add(std::chrono::microseconds duration) { samples.push_back(duration.count()); }
+
+    // p in 0..1 - returns 0 when nothing was recorded
+    long long Percentile(double p) {
+        if (samples.empty()) return 0;
+        const size_t index = std::min(samples.size() - 1, size_t(p * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+};
+
+// Accesses to data that a sequence lock guards - a reader runs concurrently with the writer and throws away
+// - what it read if the version changed, but plain loads and stores racing like that are still undefined behaviour
+// - so both sides use relaxed atomics (C++17 has no std::atomic_ref, these are the builtins it is built on)
+template <typename T>
+inline T RelaxedLoad(const T &value) { return __atomic_load_n(&value, __ATOMIC_RELAXED); }
+
+template <typename T>
+inline void RelaxedStore(T &value, T newValue) { __atomic_store_n(&value, newValue, __ATOMIC_RELAXED); }
+
+// Copies n bytes as relaxed atomic 8-byte words - n is rounded up to whole words
+// - so both buffers must be 8-byte aligned and padded to a multiple of 8 bytes
+inline void RelaxedCopy(void *to, const void *from, size_t n) {
+    uint64_t *dst = static_cast<uint64_t *>(to);
+    const uint64_t *src = static_cast<const uint64_t *>(from);
+    for (size_t w = 0; w < (n + 7) / 8; w++) RelaxedStore(dst[w], RelaxedLoad(src[w]));
+}
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread
+// - the items are allocated once and reused in place: Claim() / Publish() on the producer side
+// - Front() / Pop() on the consumer side, so big items (genomes) are never copied through it
+// - head and tail live on their own cache lines, each side keeps a cached copy of the other's index
+// - and only reloads it (acquire) when the ring looks full / empty
+template <typename T>
+struct SpscRing {
+    std::vector<T> items;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) size_t producerHead = 0;
+    alignas(64) size_t consumerTail = 0;
+
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        items.resize(size);
+        mask = size - 1;
+    }
+
+    size_t Capacity() const { return items.size(); }
+
+    // The next free item or nullptr when the ring is full - it is sent by Publish()
+    T *Claim() {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - producerHead == items.size()) {
+            producerHead = head.load(std::memory_order_acquire);
+            if (t - producerHead == items.size()) return nullptr;
+        }
+        return &items[t & mask];
+    }
+
+    void Publish() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // The oldest published item or nullptr when the ring is empty - it is released by Pop()
+    T *Front() {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == consumerTail) {
+            consumerTail = tail.load(std::memory_order_acquire);
+            if (h == consumerTail) return nullptr;
+        }
+        return &items[h & mask];
+    }
+
+    void Pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+};
+
+// Bounded blocking queue for any number of producers and consumers
+// - Push() waits while it is full, so a fast producer can't run far ahead of its consumers
+// - meant for coarse items (batches of work), where a mutex per item costs nothing
+template <typename T>
+struct BoundedQueue {
+    std::vector<T> items;
+    size_t head = 0;
+    size_t count = 0;
+    std::mutex mtx;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+    explicit BoundedQueue(size_t capacity) : items(std::max<size_t>(1, capacity)) {}
+
+    void Push(const T &item) {
+        std::unique_lock<std::mutex> lock(mtx);
+        notFull.wait(lock, [&] { return count < items.size(); });
+        items[(head + count++) % items.size()] = item;
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+
+    T Pop() {
+        std::unique_lock<std::mutex> lock(mtx);
+        notEmpty.wait(lock, [&] { return count > 0; });
+        T item = items[head];
+        head = (head + 1) % items.size();
+        count--;
+        lock.unlock();
+        notFull.notify_one();
+        return item;
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Compact binary genome record - used for migrants between processes (shm rings) and nodes (TCP)
+// - [u32 length][u64 fitness][length bytes of genome], little endian, no padding
+// - so a record is 12 bytes + the genome, and the same bytes work on every host
+constexpr size_t kGenomeRecordHeader = 12;
+
+inline size_t GenomeRecordSize(uint32_t length) { return kGenomeRecordHeader + length; }
+
+inline void PutU32(char *out, uint32_t value) {
+    for (int b = 0; b < 4; b++) out[b] = char(value >> (8 * b));
+}
+
+inline void PutU64(char *out, uint64_t value) {
+    for (int b = 0; b < 8; b++) out[b] = char(value >> (8 * b));
+}
+
+inline uint32_t GetU32(const char *in) {
+    uint32_t value = 0;
+    for (int b = 0; b < 4; b++) value |= uint32_t(uint8_t(in[b])) << (8 * b);
+    return value;
+}
+
+inline uint64_t GetU64(const char *in) {
+    uint64_t value = 0;
+    for (int b = 0; b < 8; b++) value |= uint64_t(uint8_t(in[b])) << (8 * b);
+    return value;
+}
+
+// Writes one record to out (GenomeRecordSize(length) bytes) and returns its size
+inline size_t EncodeGenome(char *out, const char *genome, uint32_t length, uint64_t fitness) {
+    PutU32(out, length);
+    PutU64(out + 4, fitness);
+    std::memcpy(out + kGenomeRecordHeader, genome, length);
+    return GenomeRecordSize(length);
+}
+
+// Reads the header of the record at in - the genome starts at in + kGenomeRecordHeader
+inline void DecodeGenomeHeader(const char *in, uint32_t &length, uint64_t &fitness) {
+    length = GetU32(in);
+    fitness = GetU64(in + 4);
+}